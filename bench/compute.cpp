@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <type_traits>
+
+#include "compute.hpp"
+
+namespace
+{
+// Roots evenly spread on the unit circle
+template <typename T>
+std::vector<comp<T>> unitRoots(std::size_t degree) {
+	std::vector<comp<T>> ret(degree);
+	for (std::size_t i = 0; i < degree; ++i) {
+		auto a = 2. * 3.14159265358979323846 * static_cast<double>(i) / static_cast<double>(degree);
+		ret[i] = comp<T>{ static_cast<T>(std::cos(a)), static_cast<T>(std::sin(a)) };
+	}
+	return ret;
+}
+} // namespace
+
+// Whole frames of FractalComputer::compute(), including the copy back to the host.
+// Arguments: width, height, cycles, degree
+template <typename T, Engine E = Engine::Sycl, Method M = Method::Newton>
+static void BM_compute(benchmark::State& state) {
+	auto width = static_cast<std::size_t>(state.range(0));
+	auto height = static_cast<std::size_t>(state.range(1));
+	auto cycles = static_cast<std::size_t>(state.range(2));
+	auto degree = static_cast<std::size_t>(state.range(3));
+	FractalComputer<T> computer{ unitRoots<T>(degree), comp<T>{ 0. }, static_cast<T>(3. / width), width, height,
+				     cycles };
+	// kernels run in the benchmarked type instead of the one picked for the view
+	computer.updatePrecision(std::is_same_v<T, float>    ? Precision::Float
+				 : std::is_same_v<T, double> ? Precision::Double
+							     : Precision::DoubleDouble);
+	computer.updateEngine(E);
+	computer.updateMethod(M);
+	// every iteration recomputes the same view
+	computer.updateCacheCapacity(0);
+	computer.compute(); // warm up, kernels are compiled on first use
+
+	std::size_t iters = 0;
+	for (auto _ : state) {
+		computer.updateCycles(cycles);
+		auto const& res = computer.compute();
+		benchmark::DoNotOptimize(res.data());
+		auto const& it = computer.getIterations();
+		iters = std::accumulate(it.begin(), it.end(), iters);
+	}
+	state.counters["pixels/s"] = benchmark::Counter(static_cast<double>(width * height),
+							benchmark::Counter::kIsIterationInvariantRate);
+	state.counters["iterations/s"] = benchmark::Counter(static_cast<double>(iters), benchmark::Counter::kIsRate);
+}
+
+// Degrees up to MAX_UNROLLED_DEGREE use unrolled kernels, 17 and 24 the generic one
+#define COMPUTE_ARGS                                                                                         \
+	ArgNames({ "width", "height", "cycles", "degree" })                                                    \
+		->Args({ 640, 360, 25, 3 })                                                                    \
+		->Args({ 1920, 1080, 25, 3 })                                                                  \
+		->Args({ 3840, 2160, 25, 3 })                                                                  \
+		->Args({ 1920, 1080, 100, 3 })                                                                 \
+		->Args({ 1920, 1080, 25, 7 })                                                                  \
+		->Args({ 1920, 1080, 25, 15 })                                                                 \
+		->Args({ 1920, 1080, 25, 16 })                                                                 \
+		->Args({ 1920, 1080, 25, 17 })                                                                 \
+		->Args({ 1920, 1080, 25, 24 })                                                                 \
+		->Unit(benchmark::kMillisecond)                                                                \
+		->UseRealTime()
+
+BENCHMARK_TEMPLATE(BM_compute, float)->COMPUTE_ARGS;
+BENCHMARK_TEMPLATE(BM_compute, double)->COMPUTE_ARGS;
+// Same frames computed by the host SIMD engine, to compare with the SYCL CPU device
+BENCHMARK_TEMPLATE(BM_compute, float, Engine::Simd)->COMPUTE_ARGS;
+BENCHMARK_TEMPLATE(BM_compute, double, Engine::Simd)->COMPUTE_ARGS;
+// The other iteration methods, cubic ones need fewer iterations but each of them costs more
+#define METHOD_ARGS                                                                                          \
+	ArgNames({ "width", "height", "cycles", "degree" })                                                    \
+		->Args({ 1920, 1080, 25, 3 })                                                                  \
+		->Args({ 1920, 1080, 100, 3 })                                                                 \
+		->Args({ 1920, 1080, 25, 7 })                                                                  \
+		->Args({ 1920, 1080, 25, 16 })                                                                 \
+		->Unit(benchmark::kMillisecond)                                                                \
+		->UseRealTime()
+
+BENCHMARK_TEMPLATE(BM_compute, double, Engine::Sycl, Method::Halley)->METHOD_ARGS;
+BENCHMARK_TEMPLATE(BM_compute, double, Engine::Sycl, Method::Householder)->METHOD_ARGS;
+BENCHMARK_TEMPLATE(BM_compute, double, Engine::Sycl, Method::Relaxed)->METHOD_ARGS;
+BENCHMARK_TEMPLATE(BM_compute, double, Engine::Simd, Method::Halley)->METHOD_ARGS;
+BENCHMARK_TEMPLATE(BM_compute, ddouble)
+	->ArgNames({ "width", "height", "cycles", "degree" })
+	->Args({ 640, 360, 25, 3 })
+	->Args({ 1920, 1080, 25, 3 })
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
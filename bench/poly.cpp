@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "comp.hpp"
+#include "poly.hpp"
+
+namespace
+{
+template <typename T, int N>
+Polynome<T, N> benchPoly() {
+	std::array<comp<T>, N> coeffs;
+	for (int i = 0; i < N; ++i)
+		coeffs[i] = comp<T>{ static_cast<T>(i + 1), static_cast<T>(N - i) };
+	return Polynome<T, N>{ std::move(coeffs) };
+}
+} // namespace
+
+template <typename T>
+static void BM_comp_div(benchmark::State& state) {
+	comp<T> z{ 1.5, -0.5 };
+	comp<T> d{ 0.3, 0.7 };
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(z);
+		benchmark::DoNotOptimize(d);
+		auto r = z / d;
+		benchmark::DoNotOptimize(r);
+	}
+}
+BENCHMARK_TEMPLATE(BM_comp_div, float);
+BENCHMARK_TEMPLATE(BM_comp_div, double);
+
+template <typename T, int N>
+static void BM_poly_apply(benchmark::State& state) {
+	auto p = benchPoly<T, N>();
+	comp<T> z{ 0.5, 0.25 };
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(z);
+		auto r = p.apply(z);
+		benchmark::DoNotOptimize(r);
+	}
+}
+BENCHMARK_TEMPLATE(BM_poly_apply, float, 4);
+BENCHMARK_TEMPLATE(BM_poly_apply, double, 4);
+BENCHMARK_TEMPLATE(BM_poly_apply, double, 8);
+BENCHMARK_TEMPLATE(BM_poly_apply, double, 16);
+
+template <typename T, int N>
+static void BM_poly_apply_with_derivative(benchmark::State& state) {
+	auto p = benchPoly<T, N>();
+	comp<T> z{ 0.5, 0.25 };
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(z);
+		auto r = p.apply_with_derivative(z);
+		benchmark::DoNotOptimize(r);
+	}
+}
+BENCHMARK_TEMPLATE(BM_poly_apply_with_derivative, float, 4);
+BENCHMARK_TEMPLATE(BM_poly_apply_with_derivative, double, 4);
+BENCHMARK_TEMPLATE(BM_poly_apply_with_derivative, double, 8);
+BENCHMARK_TEMPLATE(BM_poly_apply_with_derivative, double, 16);
+
+template <typename T, int N>
+static void BM_poly_derivative(benchmark::State& state) {
+	auto p = benchPoly<T, N>();
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(p);
+		auto d = p.derivative();
+		benchmark::DoNotOptimize(d);
+	}
+}
+BENCHMARK_TEMPLATE(BM_poly_derivative, double, 4);
+BENCHMARK_TEMPLATE(BM_poly_derivative, double, 16);
+
+template <typename T, int N>
+static void BM_poly_roots(benchmark::State& state) {
+	std::array<comp<T>, N - 1> roots;
+	for (int i = 0; i < N - 1; ++i)
+		roots[i] = comp<T>{ static_cast<T>(i) - static_cast<T>(N) / 2, static_cast<T>(i % 2) };
+	auto p = polynomFromRoots(roots);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(p);
+		auto r = p.roots();
+		benchmark::DoNotOptimize(r);
+	}
+}
+BENCHMARK_TEMPLATE(BM_poly_roots, double, 4);
+BENCHMARK_TEMPLATE(BM_poly_roots, double, 8);
+BENCHMARK_TEMPLATE(BM_poly_roots, double, 17);
+
+// Roots of a polynomial whose degree is only known at runtime, spread on a spiral
+static std::vector<comp<double>> spiralCoeffs(int degree, double twist) {
+	std::vector<comp<double>> roots;
+	for (int i = 0; i < degree; ++i) {
+		auto a = twist * i;
+		auto r = 0.5 + static_cast<double>(i) / degree;
+		roots.push_back(comp<double>{ r * std::cos(a), r * std::sin(a) });
+	}
+	return coeffsFromRoots(roots);
+}
+
+static void BM_poly_roots_runtime(benchmark::State& state) {
+	auto c = spiralCoeffs(static_cast<int>(state.range(0)), 2.4);
+	for (auto _ : state) {
+		auto r = polyRoots(c);
+		benchmark::DoNotOptimize(r);
+	}
+}
+BENCHMARK(BM_poly_roots_runtime)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+
+// A family of polynomials swept by a parameter, solved on every host thread
+static void BM_poly_roots_batch(benchmark::State& state) {
+	std::vector<std::vector<comp<double>>> family;
+	for (int i = 0; i < state.range(0); ++i)
+		family.push_back(spiralCoeffs(16, 2.4 + 0.001 * i));
+	for (auto _ : state) {
+		auto r = polyRootsBatch(family);
+		benchmark::DoNotOptimize(r);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_poly_roots_batch)->Arg(256)->Arg(4096)->UseRealTime();
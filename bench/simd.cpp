@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <numeric>
+
+#include "simd.hpp"
+
+namespace
+{
+// z^degree - 1 over a 3x3 square, with its roots
+template <typename T>
+SimdView<T> benchView(int degree, std::size_t width) {
+	SimdView<T> ret{ std::vector<T>(degree + 1), std::vector<T>(degree + 1), {}, {}, -1.5, -1.5,
+			 static_cast<T>(3. / static_cast<double>(width)), 25, static_cast<T>(1e-5) };
+	ret.coeffsRe[0] = -1;
+	ret.coeffsRe[degree] = 1;
+	for (int i = 0; i < degree; ++i) {
+		auto a = 2. * 3.14159265358979323846 * static_cast<double>(i) / static_cast<double>(degree);
+		ret.rootsRe.push_back(static_cast<T>(std::cos(a)));
+		ret.rootsIm.push_back(static_cast<T>(std::sin(a)));
+	}
+	return ret;
+}
+} // namespace
+
+// One thread of the SIMD engine on a square of pixels, for each instruction set
+// Arguments: width (the square has width^2 pixels), degree
+template <typename T, SimdIsa I>
+static void BM_simd_sample(benchmark::State& state) {
+	if (!simdIsaAvailable(I)) {
+		state.SkipWithError("instruction set not available");
+		return;
+	}
+	auto width = static_cast<std::size_t>(state.range(0));
+	auto view = benchView<T>(static_cast<int>(state.range(1)), width);
+	std::vector<Pixel> pixels;
+	for (std::uint32_t y = 0; y < width; ++y)
+		for (std::uint32_t x = 0; x < width; ++x)
+			pixels.push_back({ x, y });
+	std::vector<std::uint8_t> roots(pixels.size());
+	std::vector<int> iters(pixels.size());
+	std::vector<std::uint8_t> shades(pixels.size());
+
+	std::size_t its = 0;
+	for (auto _ : state) {
+		simdSample(view, pixels.data(), pixels.size(), roots.data(), iters.data(), shades.data(), I);
+		benchmark::DoNotOptimize(roots.data());
+		its = std::accumulate(iters.begin(), iters.end(), its);
+	}
+	state.counters["pixels/s"] = benchmark::Counter(static_cast<double>(pixels.size()),
+							benchmark::Counter::kIsIterationInvariantRate);
+	state.counters["iterations/s"] = benchmark::Counter(static_cast<double>(its), benchmark::Counter::kIsRate);
+}
+
+#define SIMD_ARGS ArgNames({ "width", "degree" })->Args({ 256, 3 })->Args({ 256, 7 })->Args({ 256, 16 })
+
+BENCHMARK_TEMPLATE(BM_simd_sample, float, SimdIsa::Generic)->SIMD_ARGS;
+BENCHMARK_TEMPLATE(BM_simd_sample, float, SimdIsa::Avx2)->SIMD_ARGS;
+BENCHMARK_TEMPLATE(BM_simd_sample, float, SimdIsa::Avx512)->SIMD_ARGS;
+BENCHMARK_TEMPLATE(BM_simd_sample, double, SimdIsa::Generic)->SIMD_ARGS;
+BENCHMARK_TEMPLATE(BM_simd_sample, double, SimdIsa::Avx2)->SIMD_ARGS;
+BENCHMARK_TEMPLATE(BM_simd_sample, double, SimdIsa::Avx512)->SIMD_ARGS;
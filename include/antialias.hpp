@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "image.hpp"
+#include "subdivide.hpp"
+
+// Adaptive anti-aliasing: only pixels on a basin boundary are supersampled. Their grid x grid samples are
+// spread evenly inside the pixel, sample (i, j) of pixel (x, y) has the coordinates (grid * x + i, grid * y + j)
+// on a grid grid times finer than the frame.
+
+// Pixels whose root differs from the one of a 4-neighbour, or whose shade differs from it by more than
+// maxShadeStep levels as smooth shading jumps there too, in row order. Shades are ignored when null.
+inline std::vector<std::uint32_t> boundaryPixels(std::uint8_t const* roots, std::size_t width, std::size_t height,
+						 std::uint8_t const* shades = nullptr, int maxShadeStep = 0) {
+	std::vector<std::uint32_t> ret;
+	auto differs = [&](std::size_t i, std::size_t j) {
+		return roots[i] != roots[j] || (shades && std::abs(shades[i] - shades[j]) > maxShadeStep);
+	};
+	for (std::size_t y = 0; y < height; ++y) {
+		for (std::size_t x = 0; x < width; ++x) {
+			auto i = y * width + x;
+			if ((x > 0 && differs(i, i - 1)) || (x + 1 < width && differs(i, i + 1)) ||
+			    (y > 0 && differs(i, i - width)) || (y + 1 < height && differs(i, i + width)))
+				ret.push_back(static_cast<std::uint32_t>(i));
+		}
+	}
+	return ret;
+}
+
+// Samples of each given pixel, grid * grid consecutive ones per pixel
+inline std::vector<Pixel> subSamples(std::vector<std::uint32_t> const& pixels, std::size_t width,
+				     std::size_t grid) {
+	std::vector<Pixel> ret;
+	ret.reserve(pixels.size() * grid * grid);
+	for (auto p : pixels) {
+		auto x = static_cast<std::uint32_t>(grid * (p % width));
+		auto y = static_cast<std::uint32_t>(grid * (p / width));
+		for (std::uint32_t j = 0; j < grid; ++j) {
+			for (std::uint32_t i = 0; i < grid; ++i)
+				ret.push_back({ x + i, y + j });
+		}
+	}
+	return ret;
+}
+
+// Mean of n colors, rounded to nearest
+inline Rgba blend(Rgba const* colors, std::size_t n) {
+	std::uint32_t r = 0, g = 0, b = 0, a = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		r += colors[i].r;
+		g += colors[i].g;
+		b += colors[i].b;
+		a += colors[i].a;
+	}
+	auto half = static_cast<std::uint32_t>(n / 2);
+	auto m = static_cast<std::uint32_t>(n);
+	return { static_cast<std::uint8_t>((r + half) / m), static_cast<std::uint8_t>((g + half) / m),
+		 static_cast<std::uint8_t>((b + half) / m), static_cast<std::uint8_t>((a + half) / m) };
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <utility>
+
+// Least recently used values, evicted once their total size goes over a budget. Lookups are linear: entries are
+// whole frames, so there are few of them and comparing keys is cheap next to computing a frame.
+template <typename Key, typename Value>
+class LruCache {
+	struct Entry {
+		Key key;
+		Value value;
+		std::size_t bytes;
+	};
+
+	std::list<Entry> entries; // most recently used first
+	std::size_t capacity;     // in bytes, 0 disables the cache
+	std::size_t used;
+	std::size_t hits;
+	std::size_t misses;
+
+	void evict() {
+		while (used > capacity) {
+			used -= entries.back().bytes;
+			entries.pop_back();
+		}
+	}
+
+    public:
+	explicit LruCache(std::size_t capacity_) : capacity{ capacity_ }, used{ 0 }, hits{ 0 }, misses{ 0 } {}
+
+	// nullptr on a miss, a hit becomes the most recently used entry. The value stays valid until the next insert.
+	Value const* find(Key const& key) {
+		auto it = std::find_if(entries.begin(), entries.end(), [&](Entry const& e) { return e.key == key; });
+		if (it == entries.end()) {
+			++misses;
+			return nullptr;
+		}
+		++hits;
+		entries.splice(entries.begin(), entries, it);
+		return &entries.front().value;
+	}
+
+	// Replaces the value of an existing key, a value larger than the whole budget is not kept
+	void insert(Key key, Value value, std::size_t bytes) {
+		auto it = std::find_if(entries.begin(), entries.end(), [&](Entry const& e) { return e.key == key; });
+		if (it != entries.end()) {
+			used -= it->bytes;
+			entries.erase(it);
+		}
+		if (bytes > capacity)
+			return;
+		entries.push_front({ std::move(key), std::move(value), bytes });
+		used += bytes;
+		evict();
+	}
+
+	void updateCapacity(std::size_t newC) {
+		capacity = newC;
+		evict();
+	}
+
+	void clear() {
+		entries.clear();
+		used = 0;
+	}
+
+	std::size_t getCapacity() const { return capacity; }
+	std::size_t getUsed() const { return used; }
+	std::size_t getSize() const { return entries.size(); }
+	std::size_t getHits() const { return hits; }
+	std::size_t getMisses() const { return misses; }
+};
@@ -60,8 +60,10 @@ class comp {
 	constexpr comp& operator/=(comp const& oth) {
 		auto denom = oth.re * oth.re + oth.im * oth.im;
 		assert(denom > 0.);
-		re = ((re * oth.re) + (im * oth.im)) / denom;
-		im = ((im * oth.re) - (re * oth.im)) / denom;
+		auto nre = ((re * oth.re) + (im * oth.im)) / denom;
+		auto nim = ((im * oth.re) - (re * oth.im)) / denom;
+		re = nre;
+		im = nim;
 		return *this;
 	}
 	friend constexpr comp operator/(comp lhs, comp const& rhs) {
@@ -101,3 +103,9 @@ constexpr T dist_squared(comp<T> const& lhs, comp<T> const& rhs) {
 	auto r = lhs.im - rhs.im;
 	return l * l + r * r;
 }
+
+// Converts between precisions, e.g. from the precision of a view to the one of a kernel
+template <typename To, typename From>
+constexpr comp<To> comp_cast(comp<From> const& c) {
+	return comp<To>{ static_cast<To>(c.re), static_cast<To>(c.im) };
+}
@@ -1,147 +1,1444 @@
 #pragma once
 
 #include <vector>
+#include <deque>
 #include <chrono>
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <numeric>
+#include <cstring>
+#include <cstdlib>
+#include <utility>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <limits>
+#include <future>
+#include <thread>
+#include <iostream>
 
 #include <CL/sycl.hpp>
 
 #include "poly.hpp"
 #include "comp.hpp"
+#include "newton.hpp"
+#include "subdivide.hpp"
+#include "stats.hpp"
+#include "image.hpp"
+#include "ddouble.hpp"
+#include "simd.hpp"
+#include "cache.hpp"
+#include "antialias.hpp"
+#include "view.hpp"
 
-constexpr auto compute_top_left(auto center, auto inc, auto w, auto h) {
-	auto left = inc * static_cast<decltype(inc)>(w / 2);
-	auto top = inc * static_cast<decltype(inc)>(h / 2);
-	return center + comp_t<decltype(inc)>(-left, -top);
+// Rectangle of pixels, in pixel coordinates of the frame
+struct Region {
+	std::size_t x, y, w, h;
+
+	constexpr std::size_t size() const { return w * h; }
+};
+
+// Host memory the device writes to directly (USM), its content is read without any copy nor accessor
+template <typename V>
+class HostArray {
+	cl::sycl::queue queue;
+	V* ptr;
+	std::size_t n;
+
+    public:
+	HostArray(cl::sycl::queue const& q, std::size_t n_)
+		: queue{ q }, ptr{ n_ > 0 ? cl::sycl::malloc_host<V>(n_, q) : nullptr }, n{ n_ } {
+		if (n_ > 0 && !ptr)
+			throw std::runtime_error("Could not allocate host memory");
+	}
+	HostArray(HostArray const&) = delete;
+	HostArray(HostArray&& o) noexcept
+		: queue{ o.queue }, ptr{ std::exchange(o.ptr, nullptr) }, n{ std::exchange(o.n, 0) } {}
+	HostArray& operator=(HostArray&& o) noexcept {
+		std::swap(queue, o.queue);
+		std::swap(ptr, o.ptr);
+		std::swap(n, o.n);
+		return *this;
+	}
+	~HostArray() {
+		if (ptr)
+			cl::sycl::free(ptr, queue);
+	}
+
+	V* data() { return ptr; }
+	V const* data() const { return ptr; }
+	std::size_t size() const { return n; }
+	V& operator[](std::size_t i) { return ptr[i]; }
+	V const& operator[](std::size_t i) const { return ptr[i]; }
+};
+
+// Kernels are fully unrolled for these polynomial degrees, other degrees use a generic kernel
+inline constexpr int MIN_UNROLLED_DEGREE = 2;
+inline constexpr int MAX_UNROLLED_DEGREE = 16;
+
+// Arithmetic used by the kernels, Auto picks the fastest one able to tell neighbouring pixels apart
+enum class Precision { Float, Double, DoubleDouble, Auto };
+
+constexpr char const* precisionName(Precision p) {
+	switch (p) {
+	case Precision::Float:
+		return "float";
+	case Precision::Double:
+		return "double";
+	case Precision::DoubleDouble:
+		return "double-double";
+	default:
+		return "auto";
+	}
 }
 
-template <typename T, int N>
+// Precision picked by Auto for a view: pixels are PRECISION_GUARD ulps apart at least, so iterates of
+// neighbouring pixels stay distinct
+inline constexpr double PRECISION_GUARD = 256.;
+
+template <typename T>
+Precision autoPrecision(comp<T> const& center, T const& inc, std::size_t width, std::size_t height) {
+	auto w = static_cast<double>(width) / 2. * static_cast<double>(inc);
+	auto h = static_cast<double>(height) / 2. * static_cast<double>(inc);
+	auto scale = std::max(
+		{ 1., mabs(static_cast<double>(center.re)) + w, mabs(static_cast<double>(center.im)) + h });
+	auto spacing = static_cast<double>(inc) / scale;
+	if (spacing >= PRECISION_GUARD * std::numeric_limits<float>::epsilon())
+		return Precision::Float;
+	if (spacing >= PRECISION_GUARD * std::numeric_limits<double>::epsilon())
+		return Precision::Double;
+	return Precision::DoubleDouble;
+}
+
+// How the colors of the roots are shaded: a single color per root, or darkened with the fractional iteration
+// count of the pixel (see shadeLevel)
+enum class Shading { Flat, Smooth };
+
+constexpr char const* shadingName(Shading s) {
+	switch (s) {
+	case Shading::Flat:
+		return "flat";
+	default:
+		return "smooth";
+	}
+}
+
+// Where the samples are computed: SYCL kernels, or host threads running the SIMD engine (float and double only,
+// double-double frames stay on SYCL)
+enum class Engine { Sycl, Simd };
+
+constexpr char const* engineName(Engine e) {
+	switch (e) {
+	case Engine::Sycl:
+		return "sycl";
+	default:
+		return "simd";
+	}
+}
+
+template <typename T>
 class FractalComputer {
-	std::array<comp<T>, N - 1> roots;
-	Polynome<T, N> poly;
-	Polynome<T, N - 1> deri;
+	std::vector<comp<T>> roots;
+	std::vector<comp<T>> coeffs; // lowest degree first, the degree is roots.size()
 	comp<T> center;
 	T inc;
 	std::size_t width;
 	std::size_t height;
 	int cycles;
+	T tolerance;
 
 	bool needCompute;
+	bool needFullCompute;
+	long panX, panY; // pixel translation since the last computation
 	float lastTimePerComputation;
 	float lastFLOPS;
 
-	cl::sycl::device device;
-	cl::sycl::queue queue;
-	cl::sycl::buffer<comp<T>, 2> zs;
-	cl::sycl::buffer<comp<T>, 2> pzs;
-	cl::sycl::buffer<comp<T>, 2> dpzs;
-	cl::sycl::buffer<T, 3> disroot;
-	cl::sycl::buffer<int, 2> closestRoot;
-	std::vector<int> cache;
+	// A part of the frame to compute, sampled every stride pixels
+	struct TileJob {
+		Region region;
+		std::size_t level;
+		std::size_t stride;
+	};
+
+	// Results of a kernel, written by the device straight into host memory
+	// The generic kernel also reads its polynomial from there, and every kernel its shaded palette. They are
+	// copied for each output as cancelled kernels may still be running when they change.
+	struct Output {
+		HostArray<std::uint8_t> roots;
+		HostArray<int> iters;
+		HostArray<std::uint8_t> shades;
+		HostArray<Rgba> colors;
+		// coefficients then roots, in the precision of the kernel
+		std::tuple<HostArray<comp<float>>, HostArray<comp<double>>, HostArray<comp<ddouble>>> poly;
+		HostArray<Rgba> lut;
+		std::size_t lutVersion; // of the shaded palette in lut, only copied again when it changed
+	};
+
+	// Start and end of a host task, in nanoseconds like the profiling of kernels
+	using TaskTime = std::pair<std::uint64_t, std::uint64_t>;
+
+	// A part of the frame computed by its own kernel into its own output
+	// The SIMD engine runs a task instead, declared after out as it writes there until it is destroyed
+	struct Tile {
+		TileJob job;
+		std::size_t dev; // index in devices
+		Output out;
+		cl::sycl::event done;
+		std::future<TaskTime> task;
+	};
+
+	std::size_t tileSize;
+	std::size_t maxTilesInFlight;
+	std::size_t coarsestStride; // first refinement level of a full frame, 1 disables progressive rendering
+	bool preview;               // views are only computed at 1/previewStride resolution, see updatePreview
+	bool framePreview;          // the current frame is a preview
+	std::size_t previewStride;
+	std::vector<std::size_t> levelStrides;
+	std::vector<std::size_t> levelTilesLeft;
+	std::vector<Tile> runningTiles;
+	std::vector<Tile> cancelledTiles; // kept alive until the device is done with them
+	std::vector<Region> finishedRegions;
+	// Pixels requested by a pass of the subdivision fill, each device computes a contiguous part of them
+	struct PixelBatch {
+		std::size_t dev;
+		std::size_t offset, size; // pixels of the pass it computes
+		std::size_t grid;         // pixel coordinates are on a grid that many times finer than the frame
+		cl::sycl::buffer<Pixel, 1> pixels;
+		Output out;
+		cl::sycl::event done;
+		std::future<TaskTime> task;
+	};
+
+	bool subdivision; // full frames are filled by rectangle subdivision instead of tiles
+	Precision precision;
+	Precision framePrecision; // used by the kernels of the current frame
+	Engine engine;
+	Engine frameEngine;
+	Method method;
+	comp<T> relaxation; // step factor of Method::Relaxed
+	std::optional<Subdivider> subdivider;
+	std::vector<PixelBatch> runningBatches; // parts of the current pass
+	std::vector<PixelBatch> cancelledBatches;
+	std::vector<std::uint8_t> passRoots;   // results of a whole pass, gathered from its parts
+	std::vector<int> passIters;
+	std::vector<std::uint8_t> passShades;
+
+	std::size_t tilesTotal;
+	std::size_t tilesDone;
+	bool frameRunning;
+	std::chrono::steady_clock::time_point frameStart;
+	FrameStats stats;
+
+	// A SYCL device the frames are split across, it computes a band of rows of each frame
+	struct DeviceSlot {
+		cl::sycl::device device;
+		cl::sycl::queue queue;
+		std::deque<TileJob> pending;
+		std::vector<Output> freeOutputs; // outputs of collected kernels, reused to avoid pinning memory again
+		double throughput;               // samples per second over the previous frames, 0 if not measured yet
+		std::uint64_t start, end;        // first start and last end of its kernels in the frame, nanoseconds
+		std::size_t kernels;
+		std::size_t samples;
+	};
+	std::deque<DeviceSlot> devices; // never reallocated, slots hold move-only outputs
+	std::vector<std::size_t> bandEnds; // last row (excluded) of the band of each device in the current frame
+
+	std::vector<Rgba> colorChoice; // given by the user, empty for the default palette
+	std::vector<Rgba> palette;     // one color per root
+	Shading shading;
+	std::vector<Rgba> lut;         // SHADE_LEVELS shades of each color of the palette
+	std::size_t lutVersion;        // incremented every time lut changes
+	std::vector<std::uint8_t> cache;
+	std::vector<int> iterCache;
+	std::vector<std::uint8_t> shadeCache; // shade level of each pixel
+	HostArray<Rgba> colors;
+
+	// Everything the pixels of a complete frame depend on, the palette excepted
+	struct FrameKey {
+		std::vector<comp<T>> coeffs;
+		comp<T> center;
+		T inc;
+		std::size_t width, height;
+		int cycles;
+		T tolerance;
+		Precision precision; // of the kernels
+		bool subdivision;    // fills rectangles without computing them
+		Method method;
+		comp<T> relaxation;
+
+		bool operator==(FrameKey const&) const = default;
+	};
+	// Compact copy of a complete frame, colors are not kept as the palette can change meanwhile
+	struct CachedFrame {
+		std::vector<std::uint8_t> roots;
+		std::vector<std::uint16_t> iters; // saturated
+		std::vector<std::uint8_t> shades;
+		// samples of the supersampled pixels, reused if the frame is restored with the same grid
+		std::size_t aaGrid;
+		std::vector<std::uint32_t> aaPixels;
+		std::vector<std::uint8_t> aaRoots, aaShades;
+	};
+	LruCache<FrameKey, CachedFrame> frameCache;
+	FrameKey frameKey; // of the current frame
+
+	// Adaptive anti-aliasing, pixels on a basin boundary are supersampled once the rest of the frame is done
+	std::size_t aaGrid;                  // samples per side of a supersampled pixel, 1 disables anti-aliasing
+	bool aaDone;                         // the supersampling of the current frame was started
+	std::vector<std::uint32_t> aaPixels; // supersampled pixels of the frame, in row order
+	std::vector<std::uint8_t> aaRoots;   // aaGrid * aaGrid sample roots of each of them
+	std::vector<std::uint8_t> aaShades;
+	// samples kept from the previous frame for the pixels a pan leaves in the frame, or restored from the cache
+	std::vector<std::uint32_t> aaKept;
+	std::vector<std::uint8_t> aaKeptRoots, aaKeptShades;
+
+	static constexpr Rgba BLACK{ 0, 0, 0, 255 };
+
+	// Every device of every backend, restricted with ACPP_VISIBILITY_MASK. Falls back to the default device if
+	// the runtime lists none.
+	static std::deque<DeviceSlot> selectDevices() {
+		auto found = cl::sycl::device::get_devices();
+		if (found.empty())
+			found.push_back(cl::sycl::device(cl::sycl::default_selector_v));
+		std::deque<DeviceSlot> ret;
+		for (auto const& d : found) {
+			ret.push_back({ d,
+					cl::sycl::queue{ d, exceptionHandler,
+							 cl::sycl::property_list{
+								 cl::sycl::property::queue::enable_profiling{} } },
+					{},
+					{},
+					0.,
+					0,
+					0,
+					0,
+					0 });
+		}
+		std::clog << "Using " << ret.size() << " device" << (ret.size() > 1 ? "s" : "") << std::endl;
+		return ret;
+	}
+
+	static void exceptionHandler(cl::sycl::exception_list exceptions) {
+		for (std::exception_ptr const& e : exceptions) {
+			try {
+				std::rethrow_exception(e);
+			} catch (cl::sycl::exception const& e) {
+				std::cerr << "Caught asynchronous SYCL exception:\n" << e.what() << std::endl;
+			}
+		}
+	}
 
 	void resize() {
-		zs = cl::sycl::buffer<comp<T>, 2>{ cl::sycl::range<2>{ height, width } };
-		pzs = cl::sycl::buffer<comp<T>, 2>{ cl::sycl::range<2>{ height, width } };
-		dpzs = cl::sycl::buffer<comp<T>, 2>{ cl::sycl::range<2>{ height, width } };
-		disroot = cl::sycl::buffer<T, 3>{ cl::sycl::range<3>{ height, width, N } };
-		closestRoot = cl::sycl::buffer<int, 2>{ cl::sycl::range<2>{ height, width } };
-		cache.resize(width * height, -1);
+		cancel();
+		// supersampled pixels of the previous size could be out of the new frame
+		aaPixels.clear();
+		aaRoots.clear();
+		aaShades.clear();
+		cache.assign(width * height, NO_ROOT);
+		iterCache.assign(width * height, 0);
+		shadeCache.assign(width * height, 0);
+		colors = HostArray<Rgba>{ devices.front().queue, width * height };
+		std::fill_n(colors.data(), colors.size(), BLACK);
 	}
 
-    public:
-	FractalComputer(std::array<comp<T>, N - 1> const& roots_, comp<T> const& center_, T const& inc_,
-			std::size_t width_, std::size_t height_, std::size_t cycles_)
-		: roots{ roots_ }, poly{ polynomFromRoots(roots) }, deri{ poly.derivative() }, center{ center_ },
-		  inc{ inc_ }, width{ width_ }, height{ height_ }, cycles{ static_cast<int>(cycles_) },
-		  needCompute{ true }, lastTimePerComputation{ -1 }, lastFLOPS{ -1 },
-		  zs{ cl::sycl::range<2>{ height, width } }, pzs{ cl::sycl::range<2>{ height, width } },
-		  dpzs{ cl::sycl::range<2>{ height, width } }, disroot{ cl::sycl::range<3>{ height, width, N } },
-		  closestRoot{ cl::sycl::range<2>{ height, width } }, cache(width * height, -1) {
-		try {
-			std::cout << "GPU...";
-			device = cl::sycl::device(cl::sycl::gpu_selector_v);
-			std::cout << " ok!" << std::endl;
-		} catch (cl::sycl::exception const& e) {
-			std::cout << "Cannot select a GPU\n" << e.what() << "\n";
-			std::cout << "Using a CPU device\n";
-			device = cl::sycl::device(cl::sycl::cpu_selector_v);
-		}
-
-		auto exception_handler = [](cl::sycl::exception_list exceptions) {
-			for (std::exception_ptr const& e : exceptions) {
-				try {
-					std::rethrow_exception(e);
-				} catch (cl::sycl::exception const& e) {
-					std::cout << "Caught asynchronous SYCL exception:\n" << e.what() << std::endl;
+	// Outputs are allocated in the context of the device writing them
+	Output takeOutput(std::size_t dev, std::size_t n) {
+		auto& freeOutputs = devices[dev].freeOutputs;
+		auto const& queue = devices[dev].queue;
+		if (freeOutputs.empty() || freeOutputs.back().roots.size() < n)
+			return { { queue, n },
+				 { queue, n },
+				 { queue, n },
+				 { queue, n },
+				 { HostArray<comp<float>>{ queue, 0 }, HostArray<comp<double>>{ queue, 0 },
+				   HostArray<comp<ddouble>>{ queue, 0 } },
+				 { queue, 0 },
+				 0 };
+		auto ret = std::move(freeOutputs.back());
+		freeOutputs.pop_back();
+		return ret;
+	}
+
+	int degree() const { return static_cast<int>(roots.size()); }
+
+	void setPolynomial(std::vector<comp<T>>&& newRoots, std::vector<comp<T>>&& newCoeffs) {
+		if (newRoots.empty() || newRoots.size() >= NO_ROOT)
+			throw std::invalid_argument("Polynomial degree must be between 1 and " +
+						    std::to_string(NO_ROOT - 1));
+		roots = std::move(newRoots);
+		coeffs = std::move(newCoeffs);
+		updatePaletteColors();
+		invalidate();
+	}
+
+	// Colors are cycled if there are less of them than roots
+	void updatePaletteColors() {
+		if (colorChoice.empty()) {
+			palette = defaultPalette(roots.size());
+		} else {
+			palette.resize(roots.size());
+			for (std::size_t i = 0; i < palette.size(); ++i)
+				palette[i] = colorChoice[i % colorChoice.size()];
+		}
+		updateLut();
+	}
+
+	// Smooth shades are about half as bright after SHADE_DECAY_STEPS Newton steps
+	void updateLut() {
+		static constexpr double SHADE_DECAY_STEPS = 8.;
+		auto decay = shading == Shading::Smooth ? SHADE_DECAY_STEPS * shadeSteps(cycles) : 0.;
+		lut = shadeTable(palette, SHADE_LEVELS, decay);
+		++lutVersion;
+	}
+
+	// The shaded palette is copied next to the output of a kernel, unless the output already holds this version
+	Rgba const* uploadLut(Output& out, cl::sycl::queue const& queue) {
+		if (out.lutVersion != lutVersion) {
+			if (out.lut.size() < lut.size())
+				out.lut = HostArray<Rgba>{ queue, lut.size() };
+			std::copy(lut.begin(), lut.end(), out.lut.data());
+			out.lutVersion = lutVersion;
+		}
+		return out.lut.data();
+	}
+
+	Rgba colorOf(std::uint8_t root, std::uint8_t shade) const {
+		return root < roots.size() ? lut[root * SHADE_LEVELS + shade] : BLACK;
+	}
+
+	// Colors of the whole frame from its root indices and shades, used when they were not computed by the device
+	void recolor() {
+		auto start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < cache.size(); ++i)
+			colors[i] = colorOf(cache[i], shadeCache[i]);
+		blendSupersampled();
+		stats.colorize += secondsSince(start);
+	}
+
+	void invalidate() {
+		needCompute = true;
+		needFullCompute = true;
+	}
+
+	// Moves the view by a whole number of pixels, keeping what was already computed
+	void pan(long dx, long dy) {
+		center = center + comp_t<T>(inc * static_cast<T>(dx), inc * static_cast<T>(dy));
+		panX += dx;
+		panY += dy;
+		needCompute = true;
+	}
+
+	// frame[y][x] = frame[y + dy][x + dx], pixels coming from outside the frame are left as is
+	template <typename V>
+	void shiftFrame(V* frame, long dx, long dy) const {
+		auto w = static_cast<long>(width);
+		auto h = static_cast<long>(height);
+		auto len = static_cast<std::size_t>(w - std::labs(dx)) * sizeof(V);
+		auto srcX = dx > 0 ? dx : 0;
+		auto dstX = dx < 0 ? -dx : 0;
+		auto shiftRow = [&](long y) {
+			std::memmove(frame + y * w + dstX, frame + (y + dy) * w + srcX, len);
+		};
+		if (dy >= 0) {
+			for (long y = 0; y < h - dy; ++y)
+				shiftRow(y);
+		} else {
+			for (long y = h - 1; y >= -dy; --y)
+				shiftRow(y);
+		}
+	}
+
+	// Keeps the samples of the frame being replaced, if its supersampling was done
+	void keepSupersampled() {
+		if (aaRoots.size() != aaPixels.size() * aaGrid * aaGrid) {
+			dropKeptSupersampled();
+		} else {
+			aaKept = std::move(aaPixels);
+			aaKeptRoots = std::move(aaRoots);
+			aaKeptShades = std::move(aaShades);
+		}
+		aaPixels.clear();
+		aaRoots.clear();
+		aaShades.clear();
+	}
+
+	void dropKeptSupersampled() {
+		aaKept.clear();
+		aaKeptRoots.clear();
+		aaKeptShades.clear();
+	}
+
+	// Kept samples follow a pan like the frame, the ones of pixels moved out of it are dropped
+	void shiftKeptSupersampled(long dx, long dy) {
+		auto n = aaGrid * aaGrid;
+		auto w = static_cast<long>(width);
+		auto h = static_cast<long>(height);
+		std::size_t kept = 0;
+		for (std::size_t k = 0; k < aaKept.size(); ++k) {
+			auto x = static_cast<long>(aaKept[k] % width) - dx;
+			auto y = static_cast<long>(aaKept[k] / width) - dy;
+			if (x < 0 || y < 0 || x >= w || y >= h)
+				continue;
+			aaKept[kept] = static_cast<std::uint32_t>(y * w + x);
+			std::copy_n(aaKeptRoots.begin() + k * n, n, aaKeptRoots.begin() + kept * n);
+			std::copy_n(aaKeptShades.begin() + k * n, n, aaKeptShades.begin() + kept * n);
+			++kept;
+		}
+		aaKept.resize(kept);
+		aaKeptRoots.resize(kept * n);
+		aaKeptShades.resize(kept * n);
+	}
+
+	// Regions which have to be computed, previous results are moved to their new place
+	// Nothing is reused if the previous frame was interrupted before completion, or computed with another precision
+	// or engine: Auto picks the precision from the center, so a pan can switch it. Previews are cheap and their
+	// blocks would be shifted off the grid of the new samples, so they are always computed whole.
+	std::vector<Region> dirtyRegions(bool lastFrameComplete, Precision lastPrecision, Engine lastEngine) {
+		auto w = static_cast<long>(width);
+		auto h = static_cast<long>(height);
+		if (needFullCompute || !lastFrameComplete || framePreview || lastPrecision != framePrecision ||
+		    lastEngine != frameEngine || std::labs(panX) >= w || std::labs(panY) >= h) {
+			dropKeptSupersampled();
+			return { Region{ 0, 0, width, height } };
+		}
+
+		shiftFrame(cache.data(), panX, panY);
+		shiftFrame(iterCache.data(), panX, panY);
+		shiftFrame(shadeCache.data(), panX, panY);
+		shiftFrame(colors.data(), panX, panY);
+		shiftKeptSupersampled(panX, panY);
+		finishedRegions.push_back({ 0, 0, width, height });
+
+		std::vector<Region> ret;
+		auto sx = static_cast<std::size_t>(std::labs(panX));
+		auto sy = static_cast<std::size_t>(std::labs(panY));
+		if (sx > 0)
+			ret.push_back({ panX > 0 ? width - sx : 0, 0, sx, height });
+		if (sy > 0)
+			ret.push_back({ panX < 0 ? sx : 0, panY > 0 ? height - sy : 0, width - sx, sy });
+		return ret;
+	}
+
+	// Splits regions in tiles of one refinement level, the ones closest to the center of the frame come first
+	void splitTiles(std::vector<Region> const& regions, std::size_t stride, std::size_t size) {
+		std::vector<TileJob> tiles;
+		for (auto const& r : regions) {
+			for (std::size_t y = r.y; y < r.y + r.h; y += size) {
+				for (std::size_t x = r.x; x < r.x + r.w; x += size) {
+					Region t{ x, y, std::min(size, r.x + r.w - x), std::min(size, r.y + r.h - y) };
+					tiles.push_back({ t, levelStrides.size(), stride });
 				}
 			}
+		}
+		auto distToCenter = [&](TileJob const& t) {
+			auto dx = static_cast<long>(2 * t.region.x + t.region.w) - static_cast<long>(width);
+			auto dy = static_cast<long>(2 * t.region.y + t.region.h) - static_cast<long>(height);
+			return dx * dx + dy * dy;
 		};
+		std::stable_sort(tiles.begin(), tiles.end(),
+				 [&](auto const& l, auto const& r) { return distToCenter(l) < distToCenter(r); });
+		// each tile goes to the device of the band holding its middle row
+		for (auto const& t : tiles) {
+			auto mid = t.region.y + t.region.h / 2;
+			auto dev = std::upper_bound(bandEnds.begin(), bandEnds.end(), mid) - bandEnds.begin();
+			devices[std::min<std::size_t>(dev, bandEnds.size() - 1)].pending.push_back(t);
+		}
+		levelStrides.push_back(stride);
+		levelTilesLeft.push_back(tiles.size());
+	}
+
+	// Kernels of every unrolled degree are instantiated once, the polynomial's degree picks one at runtime
+	using TileKernel = cl::sycl::event (FractalComputer::*)(Tile&);
+	using BatchKernel = cl::sycl::event (FractalComputer::*)(PixelBatch&);
+	static constexpr std::size_t UNROLLED_DEGREES = MAX_UNROLLED_DEGREE - MIN_UNROLLED_DEGREE + 1;
+
+	static constexpr int unrolledDegree(std::size_t i) { return MIN_UNROLLED_DEGREE + static_cast<int>(i); }
+
+	// The generic kernel of method M and precision K followed by the unrolled ones of every degree
+	template <Method M, typename K>
+	static constexpr auto tileKernelsOf() {
+		return []<std::size_t... I>(std::index_sequence<I...>) {
+			return std::array<TileKernel, 1 + sizeof...(I)>{
+				&FractalComputer::template runtimeTileKernel<M, K>,
+				&FractalComputer::template unrolledTileKernel<M, K, unrolledDegree(I)>...
+			};
+		}(std::make_index_sequence<UNROLLED_DEGREES>{});
+	}
+
+	template <Method M, typename K>
+	static constexpr auto batchKernelsOf() {
+		return []<std::size_t... I>(std::index_sequence<I...>) {
+			return std::array<BatchKernel, 1 + sizeof...(I)>{
+				&FractalComputer::template runtimeBatchKernel<M, K>,
+				&FractalComputer::template unrolledBatchKernel<M, K, unrolledDegree(I)>...
+			};
+		}(std::make_index_sequence<UNROLLED_DEGREES>{});
+	}
+
+	// Kernels of method M in every precision
+	template <Method M>
+	static constexpr auto tileKernelsOf() {
+		return std::array{ tileKernelsOf<M, float>(), tileKernelsOf<M, double>(), tileKernelsOf<M, ddouble>() };
+	}
+
+	template <Method M>
+	static constexpr auto batchKernelsOf() {
+		return std::array{ batchKernelsOf<M, float>(), batchKernelsOf<M, double>(),
+				   batchKernelsOf<M, ddouble>() };
+	}
+
+	// Position in the kernel tables of the current degree
+	std::size_t kernelIndex() const {
+		auto d = degree();
+		return d >= MIN_UNROLLED_DEGREE && d <= MAX_UNROLLED_DEGREE ? d - MIN_UNROLLED_DEGREE + 1 : 0;
+	}
+
+	// Kernel of the current method, precision and degree in a table of tileKernelsOf or batchKernelsOf
+	template <typename Table>
+	auto kernelOf(Table const& kernels) const {
+		auto m = static_cast<std::size_t>(method);
+		return kernels[m][static_cast<std::size_t>(framePrecision)][kernelIndex()];
+	}
+
+	// Kernels of every method, precision and unrolled degree are instantiated once, the method, the precision of
+	// the frame and the polynomial's degree pick one at runtime
+	Tile submitTile(TileJob const& job, std::size_t dev) {
+		static constexpr std::array kernels{ tileKernelsOf<Method::Newton>(), tileKernelsOf<Method::Halley>(),
+						     tileKernelsOf<Method::Householder>(),
+						     tileKernelsOf<Method::Relaxed>() };
+		auto gw = (job.region.w + job.stride - 1) / job.stride;
+		auto gh = (job.region.h + job.stride - 1) / job.stride;
+		Tile tile{ job, dev, takeOutput(dev, gw * gh), cl::sycl::event{}, {} };
+		if (frameEngine == Engine::Simd)
+			tile.task = framePrecision == Precision::Float ? simdTileTask<float>(tile)
+								       : simdTileTask<double>(tile);
+		else
+			tile.done = (this->*kernelOf(kernels))(tile);
+		return tile;
+	}
+
+	template <Method M, typename K, int D>
+	cl::sycl::event unrolledTileKernel(Tile& tile) {
+		return tileKernel(tile, pixelSampler<M, K, D>());
+	}
+
+	template <Method M, typename K>
+	cl::sycl::event runtimeTileKernel(Tile& tile) {
+		return tileKernel(tile, runtimePixelSampler<M, K>(tile.out, devices[tile.dev].queue));
+	}
+
+	template <typename Sampler>
+	cl::sycl::event tileKernel(Tile& tile, Sampler const& sampler) {
+		using namespace cl;
+		auto const& r = tile.job.region;
+		auto stride = tile.job.stride;
+		auto reuseCoarse = tile.job.level > 0;
+		auto gw = (r.w + stride - 1) / stride;
+		auto gh = (r.h + stride - 1) / stride;
+		auto nbRoots = degree();
+		auto* outRoots = tile.out.roots.data();
+		auto* outIters = tile.out.iters.data();
+		auto* outShades = tile.out.shades.data();
+		auto* outColors = tile.out.colors.data();
+		auto const* lut = uploadLut(tile.out, devices[tile.dev].queue);
+
+		// every Newton step of a pixel is done in a single kernel which also classifies the final z
+		// and colors it with its shade, pixels stop iterating as soon as they have converged
+		return devices[tile.dev].queue.submit([&](sycl::handler& cgh) {
+			cgh.parallel_for(sycl::range<2>{ gh, gw }, [=](sycl::id<2> id) {
+				auto i = id[0] * gw + id[1];
+				auto px = r.x + id[1] * stride;
+				auto py = r.y + id[0] * stride;
+				// samples of the previous level are already known
+				if (reuseCoarse && px % (2 * stride) == 0 && py % (2 * stride) == 0) {
+					outRoots[i] = NO_ROOT;
+					outIters[i] = 0;
+					return;
+				}
+				auto res = sampler(px, py);
+				outRoots[i] = static_cast<std::uint8_t>(res.root);
+				outIters[i] = res.iters;
+				outShades[i] = res.shade;
+				auto known = res.root >= 0 && res.root < nbRoots;
+				outColors[i] = known ? lut[res.root * SHADE_LEVELS + res.shade] : BLACK;
+			});
+		});
+	}
+
+	// px[offset, offset + n) computed by one device
+	PixelBatch submitBatch(std::vector<Pixel> const& px, std::size_t dev, std::size_t offset, std::size_t n,
+			       std::size_t grid) {
+		static constexpr std::array kernels{ batchKernelsOf<Method::Newton>(), batchKernelsOf<Method::Halley>(),
+						     batchKernelsOf<Method::Householder>(),
+						     batchKernelsOf<Method::Relaxed>() };
+		using namespace cl;
+		if (frameEngine == Engine::Simd) {
+			PixelBatch batch{ dev, offset, n, grid, sycl::buffer<Pixel, 1>{ sycl::range<1>{ 1 } },
+					  takeOutput(dev, n), sycl::event{}, {} };
+			std::vector<Pixel> part(px.begin() + offset, px.begin() + offset + n);
+			batch.task = framePrecision == Precision::Float ? simdBatchTask<float>(batch, std::move(part))
+									: simdBatchTask<double>(batch, std::move(part));
+			return batch;
+		}
+		PixelBatch batch{ dev, offset, n, grid, sycl::buffer<Pixel, 1>{ sycl::range<1>{ n } },
+				  takeOutput(dev, n), sycl::event{}, {} };
+		{
+			auto hp = batch.pixels.get_host_access(sycl::write_only);
+			std::copy(px.begin() + offset, px.begin() + offset + n, hp.begin());
+		}
+		batch.done = (this->*kernelOf(kernels))(batch);
+		return batch;
+	}
+
+	template <Method M, typename K, int D>
+	cl::sycl::event unrolledBatchKernel(PixelBatch& batch) {
+		return batchKernel(batch, pixelSampler<M, K, D>(batch.grid));
+	}
+
+	template <Method M, typename K>
+	cl::sycl::event runtimeBatchKernel(PixelBatch& batch) {
+		return batchKernel(batch, runtimePixelSampler<M, K>(batch.out, devices[batch.dev].queue, batch.grid));
+	}
+
+	template <typename Sampler>
+	cl::sycl::event batchKernel(PixelBatch& batch, Sampler const& sampler) {
+		using namespace cl;
+		auto n = batch.pixels.size();
+		auto* outRoots = batch.out.roots.data();
+		auto* outIters = batch.out.iters.data();
+		auto* outShades = batch.out.shades.data();
+
+		// filled rectangles are colored on the host, so colors are only computed there
+		return devices[batch.dev].queue.submit([&](sycl::handler& cgh) {
+			sycl::accessor apx{ batch.pixels, cgh, sycl::read_only };
+			cgh.parallel_for(sycl::range<1>{ n }, [=](sycl::id<1> id) {
+				auto res = sampler(apx[id].x, apx[id].y);
+				outRoots[id[0]] = static_cast<std::uint8_t>(res.root);
+				outIters[id[0]] = res.iters;
+				outShades[id[0]] = res.shade;
+			});
+		});
+	}
+
+	template <typename K>
+	SimdView<K> simdView(std::size_t grid = 1) const {
+		auto [tl, step] = sampleGrid<SampleCoord<K>>(grid);
+		SimdView<K> ret{ {}, {}, {}, {}, tl.re, tl.im, step, cycles, kernelTolerance<K>(), method,
+				 static_cast<K>(relaxation.re), static_cast<K>(relaxation.im) };
+		for (auto const& c : coeffs) {
+			ret.coeffsRe.push_back(static_cast<K>(c.re));
+			ret.coeffsIm.push_back(static_cast<K>(c.im));
+		}
+		for (auto const& r : roots) {
+			ret.rootsRe.push_back(static_cast<K>(r.re));
+			ret.rootsIm.push_back(static_cast<K>(r.im));
+		}
+		return ret;
+	}
+
+	static std::uint64_t nowNs() {
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+							  std::chrono::steady_clock::now().time_since_epoch())
+							  .count());
+	}
+
+	// Same outputs as tileKernel, computed by a host thread. The samples to compute are gathered first so
+	// the vectors are only filled with pixels which are actually iterated.
+	template <typename K>
+	std::future<TaskTime> simdTileTask(Tile& tile) {
+		auto const& r = tile.job.region;
+		auto stride = tile.job.stride;
+		auto reuseCoarse = tile.job.level > 0;
+		auto gw = (r.w + stride - 1) / stride;
+		auto gh = (r.h + stride - 1) / stride;
+		std::vector<Pixel> px;
+		std::vector<std::size_t> slots;
+		for (std::size_t j = 0; j < gh; ++j) {
+			for (std::size_t i = 0; i < gw; ++i) {
+				auto x = r.x + i * stride;
+				auto y = r.y + j * stride;
+				if (reuseCoarse && x % (2 * stride) == 0 && y % (2 * stride) == 0)
+					continue;
+				px.push_back({ static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y) });
+				slots.push_back(j * gw + i);
+			}
+		}
+		auto const* lut = uploadLut(tile.out, devices[tile.dev].queue);
+		return std::async(std::launch::async, [view = simdView<K>(), lut, nbRoots = roots.size(),
+						       px = std::move(px), slots = std::move(slots), n = gw * gh,
+						       outRoots = tile.out.roots.data(),
+						       outIters = tile.out.iters.data(),
+						       outShades = tile.out.shades.data(),
+						       outColors = tile.out.colors.data()] {
+			auto start = nowNs();
+			std::vector<std::uint8_t> res(px.size());
+			std::vector<int> its(px.size());
+			std::vector<std::uint8_t> shades(px.size());
+			simdSample(view, px.data(), px.size(), res.data(), its.data(), shades.data());
+			std::fill_n(outRoots, n, NO_ROOT);
+			std::fill_n(outIters, n, 0);
+			for (std::size_t k = 0; k < px.size(); ++k) {
+				outRoots[slots[k]] = res[k];
+				outIters[slots[k]] = its[k];
+				outShades[slots[k]] = shades[k];
+				outColors[slots[k]] = res[k] < nbRoots ? lut[res[k] * SHADE_LEVELS + shades[k]] : BLACK;
+			}
+			return TaskTime{ start, nowNs() };
+		});
+	}
+
+	// Same outputs as batchKernel. A pass is a single request of the subdivider, it is split between all
+	// the cores of the host.
+	template <typename K>
+	std::future<TaskTime> simdBatchTask(PixelBatch& batch, std::vector<Pixel> px) {
+		static constexpr std::size_t MIN_CHUNK = 1024;
+		return std::async(std::launch::async, [view = simdView<K>(batch.grid), px = std::move(px),
+						       outRoots = batch.out.roots.data(),
+						       outIters = batch.out.iters.data(),
+						       outShades = batch.out.shades.data()] {
+			auto start = nowNs();
+			auto threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+			auto chunk = std::max(MIN_CHUNK, (px.size() + threads - 1) / threads);
+			std::vector<std::future<void>> parts;
+			for (std::size_t b = 0; b < px.size(); b += chunk) {
+				auto n = std::min(chunk, px.size() - b);
+				parts.push_back(std::async(std::launch::async, [&, b, n] {
+					simdSample(view, px.data() + b, n, outRoots + b, outIters + b, outShades + b);
+				}));
+			}
+			for (auto& p : parts)
+				p.get();
+			return TaskTime{ start, nowNs() };
+		});
+	}
+
+	// Splits a pass of the subdivider between the devices, in proportion to their bands
+	void submitPass(std::vector<Pixel> const& px, std::size_t grid = 1) {
+		auto n = px.size();
+		std::size_t offset = 0;
+		for (std::size_t d = 0; d < bandEnds.size() && offset < n; ++d) {
+			auto next = d + 1 == bandEnds.size() ? n : n * bandEnds[d] / height;
+			if (next > offset)
+				runningBatches.push_back(submitBatch(px, d, offset, next - offset, grid));
+			offset = std::max(offset, next);
+		}
+		passRoots.resize(n);
+		passIters.resize(n);
+		passShades.resize(n);
+	}
+
+	// Gathers the parts of a finished pass into passRoots, passIters and passShades
+	void gatherPass() {
+		for (auto& b : runningBatches) {
+			recordWork(b);
+			devices[b.dev].samples += b.size;
+			std::copy_n(b.out.roots.data(), b.size, passRoots.begin() + b.offset);
+			std::copy_n(b.out.iters.data(), b.size, passIters.begin() + b.offset);
+			std::copy_n(b.out.shades.data(), b.size, passShades.begin() + b.offset);
+			devices[b.dev].freeOutputs.push_back(std::move(b.out));
+		}
+		runningBatches.clear();
+		stats.iterations = std::accumulate(passIters.begin(), passIters.end(), stats.iterations);
+		stats.pixels += passRoots.size();
+	}
+
+	// Hands a finished pass to the subdivider and submits the next one
+	void collectPass() {
+		gatherPass();
+		auto start = std::chrono::steady_clock::now();
+		subdivider->provide(passRoots.data(), passIters.data(), passShades.data(), cache, iterCache,
+				    shadeCache);
+		stats.host += secondsSince(start);
+		recolor();
+		finishedRegions.push_back({ 0, 0, width, height });
+		if (subdivider->done()) {
+			subdivider.reset();
+			--levelTilesLeft[0];
+			++tilesDone;
+		} else {
+			submitPass(subdivider->requests());
+		}
+	}
+
+	// Once every tile of a frame is done, submits the samples of the pixels on a basin boundary or a jump of
+	// shades. False if there is nothing to supersample.
+	bool startSupersampling() {
+		aaDone = true;
+		if (aaGrid == 1 || framePreview)
+			return false;
+		auto start = std::chrono::steady_clock::now();
+		// shade jumps of more than a Newton step, whatever the shading so switching it only recolors the frame
+		auto maxShadeStep = std::max(1, static_cast<int>(shadeSteps(cycles)));
+		aaPixels = boundaryPixels(cache.data(), width, height, shadeCache.data(), maxShadeStep);
+		std::vector<std::uint32_t> missing; // without kept samples
+		for (auto p : aaPixels) {
+			if (!std::binary_search(aaKept.begin(), aaKept.end(), p))
+				missing.push_back(p);
+		}
+		stats.host += secondsSince(start);
+		if (aaPixels.empty()) {
+			dropKeptSupersampled();
+			return false;
+		}
+		if (missing.empty()) {
+			assembleSupersampled();
+			return false;
+		}
+		submitPass(subSamples(missing, width, aaGrid), aaGrid);
+		return true;
+	}
+
+	void collectSupersampling() {
+		gatherPass();
+		assembleSupersampled();
+	}
+
+	// Samples of every supersampled pixel, computed by the pass or kept from a previous frame, are blended
+	void assembleSupersampled() {
+		auto start = std::chrono::steady_clock::now();
+		auto n = aaGrid * aaGrid;
+		aaRoots.resize(aaPixels.size() * n);
+		aaShades.resize(aaPixels.size() * n);
+		std::size_t computed = 0; // pixels of the pass
+		for (std::size_t k = 0; k < aaPixels.size(); ++k) {
+			auto kept = std::lower_bound(aaKept.begin(), aaKept.end(), aaPixels[k]);
+			auto from = computed * n;
+			auto const* roots = passRoots.data();
+			auto const* shades = passShades.data();
+			if (kept != aaKept.end() && *kept == aaPixels[k]) {
+				from = static_cast<std::size_t>(kept - aaKept.begin()) * n;
+				roots = aaKeptRoots.data();
+				shades = aaKeptShades.data();
+			} else {
+				++computed;
+			}
+			std::copy_n(roots + from, n, aaRoots.begin() + k * n);
+			std::copy_n(shades + from, n, aaShades.begin() + k * n);
+		}
+		dropKeptSupersampled();
+		blendSupersampled();
+		stats.colorize += secondsSince(start);
+		finishedRegions.push_back({ 0, 0, width, height });
+	}
+
+	// Colors of the supersampled pixels are the mean of the colors of their samples
+	void blendSupersampled() {
+		auto n = aaGrid * aaGrid;
+		if (aaRoots.size() != aaPixels.size() * n)
+			return;
+		std::vector<Rgba> samples(n);
+		for (std::size_t k = 0; k < aaPixels.size(); ++k) {
+			for (std::size_t i = 0; i < n; ++i)
+				samples[i] = colorOf(aaRoots[k * n + i], aaShades[k * n + i]);
+			colors[aaPixels[k]] = blend(samples.data(), n);
+		}
+	}
+
+	// Accounts the execution of a finished kernel or task, errors of a task are thrown from here
+	template <typename Work>
+	void recordWork(Work& w) {
+		using namespace cl;
+		if (w.task.valid()) {
+			auto [start, end] = w.task.get();
+			recordKernel(w.dev, start, end);
+			return;
+		}
+		recordKernel(w.dev, w.done.template get_profiling_info<sycl::info::event_profiling::command_start>(),
+			     w.done.template get_profiling_info<sycl::info::event_profiling::command_end>());
+	}
+
+	// Devices have their own clocks, the frame lasts as long as the busiest one
+	void recordKernel(std::size_t dev, std::uint64_t start, std::uint64_t end) {
+		auto& d = devices[dev];
+		d.start = d.kernels == 0 ? start : std::min(d.start, start);
+		d.end = d.kernels == 0 ? end : std::max(d.end, end);
+		++d.kernels;
+		stats.kernel += static_cast<double>(end - start) / 1e9;
+		stats.kernelSpan = std::max(stats.kernelSpan, static_cast<double>(d.end - d.start) / 1e9);
+		++stats.kernels;
+	}
+
+	// Below a few ulps convergence can't be detected anymore, the tolerance is raised to stay reachable
+	template <typename K>
+	K kernelTolerance() const {
+		return std::max(static_cast<K>(tolerance), static_cast<K>(16.) * std::numeric_limits<K>::epsilon());
+	}
+
+	// Top left sample and distance between samples of a grid grid times finer than the frame, its samples are
+	// centered in the pixels: grid 1 is the frame itself
+	template <typename K>
+	std::pair<comp<K>, K> sampleGrid(std::size_t grid) const {
+		auto tl = compute_top_left(center, inc, width, height);
+		if (grid == 1)
+			return { comp_cast<K>(tl), static_cast<K>(inc) };
+		auto step = inc / static_cast<T>(static_cast<double>(grid));
+		auto shift = (step - inc) * static_cast<T>(0.5);
+		return { comp_cast<K>(tl + comp_t<T>(T{ shift }, T{ shift })), static_cast<K>(step) };
+	}
+
+	template <Method M, typename K, int D>
+	PixelSampler<K, D + 1, M> pixelSampler(std::size_t grid = 1) const {
+		std::array<comp<K>, D + 1> c;
+		std::array<comp<K>, D> r;
+		std::transform(coeffs.begin(), coeffs.end(), c.begin(), comp_cast<K, T>);
+		std::transform(roots.begin(), roots.end(), r.begin(), comp_cast<K, T>);
+		auto [tl, step] = sampleGrid<SampleCoord<K>>(grid);
+		return { Polynome<K, D + 1>{ std::move(c) }, r, tl, step, cycles, kernelTolerance<K>(),
+			 comp_cast<K>(relaxation) };
+	}
+
+	// Copies the polynomial next to the output of the kernel
+	template <Method M, typename K>
+	RuntimePixelSampler<K, M> runtimePixelSampler(Output& out, cl::sycl::queue const& queue, std::size_t grid = 1) {
+		auto d = roots.size();
+		auto& poly = std::get<HostArray<comp<K>>>(out.poly);
+		if (poly.size() < 2 * d + 1)
+			poly = HostArray<comp<K>>{ queue, 2 * d + 1 };
+		std::transform(coeffs.begin(), coeffs.end(), poly.data(), comp_cast<K, T>);
+		std::transform(roots.begin(), roots.end(), poly.data() + d + 1, comp_cast<K, T>);
+		auto [tl, step] = sampleGrid<SampleCoord<K>>(grid);
+		return { PolyView<K>{ poly.data(), degree() }, poly.data() + d + 1, tl, step, cycles,
+			 kernelTolerance<K>(), comp_cast<K>(relaxation) };
+	}
+
+	static bool isDone(cl::sycl::event const& e) {
+		return e.get_info<cl::sycl::info::event::command_execution_status>() ==
+		       cl::sycl::info::event_command_status::complete;
+	}
+
+	// Tile or batch, run by either engine
+	template <typename Work>
+	static bool isFinished(Work const& w) {
+		if (w.task.valid())
+			return w.task.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+		return isDone(w.done);
+	}
+
+	// Tiles in flight on each device, tasks of the SIMD engine each take a core of the host
+	std::size_t tilesInFlight() const {
+		if (frameEngine == Engine::Simd)
+			return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		return maxTilesInFlight;
+	}
+
+	// Blocks until a running tile or batch of the SIMD engine is finished, kernels are waited for by the queues
+	void waitForTask() {
+		if (!runningBatches.empty() && runningBatches.front().task.valid())
+			runningBatches.front().task.wait();
+		else if (!runningTiles.empty() && runningTiles.front().task.valid())
+			runningTiles.front().task.wait();
+	}
+
+	// Places a finished tile into the frame, each sample fills its stride x stride block
+	// Samples skipped because a coarser level already computed them are marked with NO_ROOT
+	void collectTile(Tile& tile) {
+		recordWork(tile);
+		auto start = std::chrono::steady_clock::now();
+		auto const& r = tile.job.region;
+		auto stride = tile.job.stride;
+		auto gw = (r.w + stride - 1) / stride;
+		auto n = gw * ((r.h + stride - 1) / stride);
+		auto const* ha = tile.out.roots.data();
+		auto const* hi = tile.out.iters.data();
+		auto const* hs = tile.out.shades.data();
+		auto const* hc = tile.out.colors.data();
+		if (stride == 1 && tile.job.level == 0) {
+			for (std::size_t y = 0; y < r.h; ++y) {
+				auto off = (r.y + y) * width + r.x;
+				std::copy(ha + y * r.w, ha + (y + 1) * r.w, cache.begin() + off);
+				std::copy(hi + y * r.w, hi + (y + 1) * r.w, iterCache.begin() + off);
+				std::copy(hs + y * r.w, hs + (y + 1) * r.w, shadeCache.begin() + off);
+				std::copy(hc + y * r.w, hc + (y + 1) * r.w, colors.data() + off);
+			}
+		} else {
+			for (std::size_t y = 0; y < r.h; ++y) {
+				auto off = (r.y + y) * width + r.x;
+				auto src = (y / stride) * gw;
+				for (std::size_t x = 0; x < r.w; ++x) {
+					auto s = src + x / stride;
+					if (ha[s] == NO_ROOT)
+						continue;
+					cache[off + x] = ha[s];
+					iterCache[off + x] = hi[s];
+					shadeCache[off + x] = hs[s];
+					colors[off + x] = hc[s];
+				}
+			}
+		}
+		auto samples = std::count_if(ha, ha + n, [](std::uint8_t v) { return v != NO_ROOT; });
+		stats.iterations = std::accumulate(hi, hi + n, stats.iterations);
+		stats.pixels += samples;
+		stats.transfer += secondsSince(start);
+		auto& dev = devices[tile.dev];
+		dev.samples += samples;
+		dev.freeOutputs.push_back(std::move(tile.out));
+		finishedRegions.push_back(r);
+		--levelTilesLeft[tile.job.level];
+		++tilesDone;
+	}
+
+	// A preview superseded by a newer view is not cancelled: its running tiles are still shown and its pending ones
+	// are never submitted, so the devices only ever compute the latest of the views requested meanwhile instead of
+	// queueing kernels for all of them
+	bool waitingForPreview() const { return framePreview && frameRunning && !runningTiles.empty(); }
+
+	// Outstanding tiles are dropped, the ones already on the device have their result ignored
+	void cancel() {
+		for (auto& d : devices)
+			d.pending.clear();
+		std::move(runningTiles.begin(), runningTiles.end(), std::back_inserter(cancelledTiles));
+		runningTiles.clear();
+		std::move(runningBatches.begin(), runningBatches.end(), std::back_inserter(cancelledBatches));
+		runningBatches.clear();
+		subdivider.reset();
+		frameRunning = false;
+	}
+
+	// Rows of the frame are shared between the devices in proportion to their throughput. Devices not
+	// measured yet are assumed as fast as the average of the others. The SIMD engine only uses the first slot.
+	void splitBands() {
+		auto n = frameEngine == Engine::Simd ? std::size_t{ 1 } : devices.size();
+		std::vector<double> weights;
+		for (std::size_t d = 0; d < n; ++d)
+			weights.push_back(devices[d].throughput);
+		auto measured = std::count_if(weights.begin(), weights.end(), [](double w) { return w > 0.; });
+		auto mean = measured > 0 ? std::accumulate(weights.begin(), weights.end(), 0.) / measured : 1.;
+		for (auto& w : weights)
+			w = w > 0. ? w : mean;
+		auto total = std::accumulate(weights.begin(), weights.end(), 0.);
+
+		bandEnds.clear();
+		double acc = 0.;
+		for (auto w : weights) {
+			acc += w;
+			bandEnds.push_back(static_cast<std::size_t>(static_cast<double>(height) * acc / total + 0.5));
+		}
+		bandEnds.back() = height;
+	}
+
+	// Throughput of a device is averaged with the previous frames so a single frame doesn't move the bands too much
+	void updateThroughputs() {
+		static constexpr double SMOOTHING = 0.5;
+		if (frameEngine != Engine::Sycl)
+			return;
+		for (auto& d : devices) {
+			if (d.kernels == 0 || d.end <= d.start)
+				continue;
+			auto rate = static_cast<double>(d.samples) / (static_cast<double>(d.end - d.start) / 1e9);
+			d.throughput = d.throughput > 0. ? SMOOTHING * d.throughput + (1. - SMOOTHING) * rate : rate;
+		}
+	}
+
+	// A device with nothing left in its band takes the last tile of the device with the most pending ones
+	bool stealTile(std::size_t dev) {
+		auto victim = std::max_element(devices.begin(), devices.end(), [](auto const& l, auto const& r) {
+			return l.pending.size() < r.pending.size();
+		});
+		if (victim->pending.empty() || victim == devices.begin() + dev)
+			return false;
+		devices[dev].pending.push_back(victim->pending.back());
+		victim->pending.pop_back();
+		return true;
+	}
+
+	bool coarserLevelsDone(std::size_t level) const {
+		return std::all_of(levelTilesLeft.begin(), levelTilesLeft.begin() + level,
+				   [](auto n) { return n == 0; });
+	}
+
+	std::size_t pendingTiles() const {
+		return std::accumulate(devices.begin(), devices.end(), std::size_t{ 0 },
+				       [](std::size_t acc, DeviceSlot const& d) { return acc + d.pending.size(); });
+	}
+
+	FrameKey currentKey() const {
+		// the factor only matters to relaxed Newton
+		auto factor = method == Method::Relaxed ? relaxation : comp<T>{ 1. };
+		return { coeffs, center, inc, width, height, cycles, tolerance, framePrecision, subdivision,
+			 method, factor };
+	}
+
+	// A view computed before is copied back instead of being computed, with the current palette
+	void restoreFrame(CachedFrame const& f) {
+		auto start = std::chrono::steady_clock::now();
+		std::copy(f.roots.begin(), f.roots.end(), cache.begin());
+		std::copy(f.iters.begin(), f.iters.end(), iterCache.begin());
+		std::copy(f.shades.begin(), f.shades.end(), shadeCache.begin());
+		stats.transfer += secondsSince(start);
+		recolor();
+		finishedRegions.push_back({ 0, 0, width, height });
+		levelStrides.assign(1, 1);
+		levelTilesLeft.assign(1, 0);
+		tilesTotal = 0;
+		tilesDone = 0;
+		needCompute = false;
+		needFullCompute = false;
+		panX = 0;
+		panY = 0;
+		// poll finds the boundary pixels again before finishing the frame, their cached samples are reused
+		if (aaGrid > 1) {
+			if (f.aaGrid == aaGrid) {
+				aaKept = f.aaPixels;
+				aaKeptRoots = f.aaRoots;
+				aaKeptShades = f.aaShades;
+			} else {
+				dropKeptSupersampled();
+			}
+			frameRunning = true;
+			return;
+		}
+		stats.wall = secondsSince(frameStart);
+		stats.complete = true;
+	}
+
+	void storeFrame() {
+		CachedFrame f{ cache, std::vector<std::uint16_t>(iterCache.size()), shadeCache, aaGrid, aaPixels,
+			       aaRoots, aaShades };
+		std::transform(iterCache.begin(), iterCache.end(), f.iters.begin(), [](int i) {
+			auto max = int{ std::numeric_limits<std::uint16_t>::max() };
+			return static_cast<std::uint16_t>(std::clamp(i, 0, max));
+		});
+		auto bytes = f.roots.size() * sizeof(std::uint8_t) + f.iters.size() * sizeof(std::uint16_t) +
+			     f.shades.size() * sizeof(std::uint8_t) + f.aaPixels.size() * sizeof(std::uint32_t) +
+			     (f.aaRoots.size() + f.aaShades.size()) * sizeof(std::uint8_t);
+		frameCache.insert(frameKey, std::move(f), bytes);
+	}
+
+	void startFrame() {
+		bool lastFrameComplete = !frameRunning;
+		auto lastPrecision = framePrecision;
+		auto lastEngine = frameEngine;
+		cancel();
+		frameStart = std::chrono::steady_clock::now();
+		stats = FrameStats{ .frame = stats.frame + 1 };
+		framePrecision = precision == Precision::Auto ? autoPrecision(center, inc, width, height) : precision;
+		frameEngine = framePrecision == Precision::DoubleDouble ? Engine::Sycl : engine;
+		framePreview = preview;
+		// a pan shifts the colors, blends of the previous frame could land on pixels no longer on a boundary
+		for (auto p : aaPixels)
+			colors[p] = colorOf(cache[p], shadeCache[p]);
+		aaDone = false;
+		keepSupersampled();
+		// a restored frame may still be supersampled, on the bands of this frame
+		for (auto& d : devices) {
+			d.kernels = 0;
+			d.samples = 0;
+		}
+		splitBands();
+		frameKey = currentKey();
+		if (auto const* hit = frameCache.find(frameKey)) {
+			restoreFrame(*hit);
+			return;
+		}
+		levelStrides.clear();
+		levelTilesLeft.clear();
+		auto regions = dirtyRegions(lastFrameComplete, lastPrecision, lastEngine);
+		// only full frames are refined progressively, strips uncovered by a pan are small
+		auto fullFrame = regions.size() == 1 && regions[0].size() == width * height;
+		if (framePreview) {
+			// a single coarse level, its tiles hold as many samples as full resolution ones
+			splitTiles(regions, previewStride, tileSize * previewStride);
+		} else if (fullFrame && subdivision) {
+			subdivider.emplace(width, height);
+			submitPass(subdivider->requests());
+			levelStrides.push_back(1);
+			levelTilesLeft.push_back(1);
+		} else {
+			for (auto stride = fullFrame ? coarsestStride : 1; stride >= 1; stride /= 2) {
+				splitTiles(regions, stride, tileSize);
+			}
+		}
+		tilesTotal = subdivider ? 1 : pendingTiles();
+		tilesDone = 0;
+		frameRunning = true;
+		needCompute = false;
+		needFullCompute = false;
+		panX = 0;
+		panY = 0;
+	}
 
-		queue = cl::sycl::queue{ device, std::move(exception_handler) };
+	void finishFrame() {
+		auto elapsed_sec = secondsSince(frameStart);
+
+		// pixels exit early, so only the iterations that were actually done are counted
+		// Horner pass for p and p' (2 complex fma per coefficient), tolerance tests, division and update
+		// The cubic methods also compute p'' (one more complex fma per coefficient), p'' / 2p' and u t, Halley
+		// divides once more while Householder adds u (u t); relaxed Newton multiplies the step by its factor
+		// The device time excludes the scheduling and the copies back to the host
+		auto flopsPerItemPerIter = 16 * degree() + 3 + 3 + 11 + 2 + 3;
+		if (method == Method::Halley)
+			flopsPerItemPerIter += 8 * degree() + 6 + 6 + 2 + 11;
+		else if (method == Method::Householder)
+			flopsPerItemPerIter += 8 * degree() + 6 + 6 + 8;
+		else if (method == Method::Relaxed)
+			flopsPerItemPerIter += 6;
+		auto nb_flop = static_cast<double>(flopsPerItemPerIter) * static_cast<double>(stats.iterations);
+		auto flops = stats.kernelSpan > 0. ? nb_flop / stats.kernelSpan : 0.;
+
+		stats.wall = elapsed_sec;
+		stats.flops = flops;
+		stats.complete = true;
+		updateThroughputs();
+		lastTimePerComputation = elapsed_sec;
+		lastFLOPS = flops;
+		frameRunning = false;
+		// previews are never shown again, the full quality frame follows them
+		if (!framePreview)
+			storeFrame();
+	}
+
+    public:
+	static constexpr std::uint8_t NO_ROOT = 0xff;
+	static constexpr std::size_t DEFAULT_CACHE_CAPACITY = 256 << 20;
+	static constexpr std::size_t MAX_SAMPLES = 256;
+
+	FractalComputer(std::vector<comp<T>> const& roots_, comp<T> const& center_, T const& inc_, std::size_t width_,
+			std::size_t height_, std::size_t cycles_, T const& tolerance_ = T{ 1e-6 })
+		: center{ center_ },
+		  inc{ inc_ }, width{ width_ }, height{ height_ }, cycles{ static_cast<int>(cycles_) },
+		  tolerance{ tolerance_ }, needCompute{ true }, needFullCompute{ true }, panX{ 0 }, panY{ 0 },
+		  lastTimePerComputation{ -1 }, lastFLOPS{ -1 }, tileSize{ 128 }, maxTilesInFlight{ 8 },
+		  coarsestStride{ 8 }, preview{ false }, framePreview{ false }, previewStride{ 8 },
+		  subdivision{ false }, precision{ Precision::Auto }, framePrecision{ Precision::Double },
+		  engine{ Engine::Sycl }, frameEngine{ Engine::Sycl }, method{ Method::Newton }, relaxation{ 1. },
+		  tilesTotal{ 0 }, tilesDone{ 0 }, frameRunning{ false }, devices{ selectDevices() },
+		  shading{ Shading::Smooth }, lutVersion{ 0 }, cache(width * height, NO_ROOT),
+		  iterCache(width * height, 0), shadeCache(width * height, 0),
+		  colors{ devices.front().queue, width * height }, frameCache{ DEFAULT_CACHE_CAPACITY }, aaGrid{ 1 },
+		  aaDone{ false } {
+		updatePolyFromRoots(roots_);
+		std::fill_n(colors.data(), colors.size(), BLACK);
+	}
+
+	FractalComputer(FractalComputer const&) = delete;
+	FractalComputer& operator=(FractalComputer const&) = delete;
+
+	// kernels still running write into memory owned by the computer
+	~FractalComputer() {
+		for (auto& d : devices)
+			d.queue.wait();
 	}
 
 	template <typename O>
 	void printDeviceInfos(O& os) const {
-		os << "Device: " << device.get_info<cl::sycl::info::device::name>()
-		   << "\nPlatform: " << device.get_platform().get_info<cl::sycl::info::platform::name>()
-		   << "\nVendor: " << device.get_info<cl::sycl::info::device::vendor>() << "\n";
+		for (auto const& d : devices) {
+			os << "Device: " << d.device.template get_info<cl::sycl::info::device::name>()
+			   << "\nPlatform: "
+			   << d.device.get_platform().template get_info<cl::sycl::info::platform::name>()
+			   << "\nVendor: " << d.device.template get_info<cl::sycl::info::device::vendor>() << "\n";
+		}
 	}
 
-	void updatePoly(Polynome<T, N> const& newP) {
-		poly = newP;
-		deri = newP.derivative();
-		roots = poly.roots();
-		needCompute = true;
+	// Coefficients are given lowest degree first, the degree can change from one call to the next
+	void updatePoly(std::vector<comp<T>> newC) {
+		while (!newC.empty() && newC.back().is_zero())
+			newC.pop_back();
+		if (newC.size() < 2)
+			throw std::invalid_argument("Polynomial degree must be at least 1");
+		auto newR = polyRoots(newC);
+		setPolynomial(std::move(newR), std::move(newC));
 	}
 
-	void updatePolyFromRoots(std::array<comp<T>, N> const& newR) {
-		roots = newR;
-		poly = polynomFromRoots(newR);
-		deri = poly.derivative();
-		needCompute = true;
+	template <int M>
+	void updatePoly(Polynome<T, M> const& newP) {
+		updatePoly(std::vector<comp<T>>(newP.coeffs().begin(), newP.coeffs().end()));
+	}
+
+	void updatePolyFromRoots(std::vector<comp<T>> const& newR) {
+		setPolynomial(std::vector<comp<T>>(newR), coeffsFromRoots(newR));
 	}
 
 	void updateCenter(comp<T> const& newC) {
 		center = newC;
-		needCompute = true;
+		invalidate();
 	}
 
 	void updateInc(T const& newI) {
 		inc = newI;
-		needCompute = true;
+		invalidate();
 	}
 
 	void updateWidth(std::size_t newW) {
 		width = newW;
 		resize();
-		needCompute = true;
+		invalidate();
 	}
 
 	void updateHeight(std::size_t newH) {
 		height = newH;
 		resize();
-		needCompute = true;
+		invalidate();
 	}
 
 	void updateCycles(std::size_t newC) {
 		cycles = static_cast<int>(newC);
-		needCompute = true;
+		updateLut(); // levels per step depend on cycles
+		invalidate();
+	}
+
+	void updateTolerance(T const& newT) {
+		tolerance = newT;
+		invalidate();
+	}
+
+	// Colors are cycled if there are less of them than roots. A complete frame is recolored without being
+	// recomputed, kernels of a running one already captured the previous palette so it is restarted.
+	void updatePalette(std::vector<Rgba> const& newP) {
+		if (newP.empty())
+			throw std::invalid_argument("Empty palette");
+		colorChoice = newP;
+		updatePaletteColors();
+		if (frameRunning) {
+			invalidate();
+			return;
+		}
+		recolor();
+		finishedRegions.push_back({ 0, 0, width, height });
+	}
+
+	// Flat colors each root with a single color, Smooth darkens it with the fractional iteration count. Shades are
+	// always computed, so a complete frame is recolored without being recomputed.
+	void updateShading(Shading newS) {
+		shading = newS;
+		updateLut();
+		if (frameRunning) {
+			invalidate();
+			return;
+		}
+		recolor();
+		finishedRegions.push_back({ 0, 0, width, height });
 	}
 
-	Polynome<T, N> const& getPoly() const { return poly; }
-	std::array<comp<T>, N - 1> const& getRoots() const { return roots; }
+	// Coefficients, lowest degree first
+	std::vector<comp<T>> const& getPoly() const { return coeffs; }
+	std::vector<comp<T>> const& getRoots() const { return roots; }
+	std::size_t getDegree() const { return roots.size(); }
 	comp<T> const& getCenter() const { return center; }
 	T const& getIncrement() const { return inc; }
 	std::size_t getWidth() const { return width; }
 	std::size_t getHeight() const { return height; }
 	float getFLOPS() const { return lastFLOPS; }
 	float getIterTime() const { return lastTimePerComputation; }
+	// Statistics of the frame being computed, or of the last one once it is complete
+	FrameStats const& getFrameStats() const { return stats; }
 	std::size_t getCycles() const { return static_cast<std::size_t>(cycles); }
+	T const& getTolerance() const { return tolerance; }
+	// Root index of each pixel, possibly still being computed (see poll), NO_ROOT if not known yet
+	std::vector<std::uint8_t> const& getResult() const { return cache; }
+	// RGBA color of each pixel in host memory, ready to be uploaded as is
+	Rgba const* getColors() const { return colors.data(); }
+	std::vector<Rgba> const& getPalette() const { return palette; }
+	Shading getShading() const { return shading; }
+	// Shade level of each pixel, see shadeLevel
+	std::vector<std::uint8_t> const& getShades() const { return shadeCache; }
+	// Newton steps used by each pixel during the last computation
+	std::vector<int> const& getIterations() const { return iterCache; }
 
 	void move(comp<T> const& vec) { updateCenter(center + vec); }
-	void moveUp(int fac) { move({ 0., -inc * fac }); }
-	void moveDown(int fac) { move({ 0., inc * fac }); }
-	void moveLeft(int fac) { move({ -inc * fac, 0. }); }
-	void moveRight(int fac) { move({ inc * fac, 0. }); }
+	void moveUp(int fac) { pan(0, -fac); }
+	void moveDown(int fac) { pan(0, fac); }
+	void moveLeft(int fac) { pan(-fac, 0); }
+	void moveRight(int fac) { pan(fac, 0); }
 
 	void zoomIn(int fac) { updateInc(inc * pw(0.9, fac)); }
 	void zoomOut(int fac) { updateInc(inc * pw(1.1, fac)); }
@@ -149,90 +1446,204 @@ class FractalComputer {
 	void increaseIters(int fac) { updateCycles(static_cast<decltype(cycles)>(cycles * pw(1.1, fac))); }
 	void decreaseIters(int fac) { updateCycles(static_cast<decltype(cycles)>(cycles * pw(0.9, fac))); }
 
-	std::vector<int> const& compute() {
-		using namespace cl;
-		if (!needCompute)
-			return cache;
-		//return std::mdspan(cache.data(), height, width);
+	void updateTileSize(std::size_t newS) {
+		tileSize = newS;
+		// tiles have to be aligned on the coarsest sampling grid
+		coarsestStride = std::min(coarsestStride, tileSize & (~tileSize + 1));
+		invalidate();
+	}
 
-		auto start = std::chrono::high_resolution_clock::now();
-		auto top_left = compute_top_left(center, inc, width, height);
-		auto polyc = this->poly;
-		auto inc = this->inc;
-		auto deric = this->deri;
-		auto rootc = this->roots;
-
-		queue.submit([&](sycl::handler& cgh) {
-			sycl::accessor writeZs{ zs, cgh, sycl::write_only, sycl::no_init };
-			cgh.parallel_for(sycl::range<2>{ height, width }, [=](sycl::id<2> id) {
-				writeZs[id] = top_left + comp_t<T>(id[1] * inc, id[0] * inc);
-			});
-		});
-		for (int i = 0; i < cycles; ++i) {
-			queue.submit([&](sycl::handler& cgh) {
-				sycl::accessor apzs{ pzs, cgh, sycl::write_only, sycl::no_init };
-				sycl::accessor azns{ zs, cgh, sycl::read_only };
-				cgh.parallel_for(sycl::range<2>{ height, width },
-						 [=](sycl::id<2> id) { apzs[id] = polyc.apply(azns[id]); });
-			});
-			queue.submit([&](sycl::handler& cgh) {
-				sycl::accessor adpzs{ dpzs, cgh, sycl::write_only, sycl::no_init };
-				sycl::accessor azns{ zs, cgh, sycl::read_only };
-				cgh.parallel_for(sycl::range<2>{ height, width },
-						 [=](sycl::id<2> id) { adpzs[id] = deric.apply(azns[id]); });
-			});
-			queue.submit([&](sycl::handler& cgh) {
-				sycl::accessor apzs{ pzs, cgh, sycl::read_only };
-				sycl::accessor adpzs{ dpzs, cgh, sycl::read_only };
-				sycl::accessor azns{ zs, cgh, sycl::read_write };
-				cgh.parallel_for(sycl::range<2>{ height, width }, [=](sycl::id<2> id) {
-					azns[id] = adpzs[id].is_zero() ? azns[id] : azns[id] - (apzs[id] / adpzs[id]);
-				});
-			});
-		}
+	// On each device
+	void updateMaxTilesInFlight(std::size_t newM) { maxTilesInFlight = newM; }
 
-		queue.submit([&](sycl::handler& cgh) {
-			sycl::accessor drw{ disroot, cgh, sycl::write_only, sycl::no_init };
-			sycl::accessor azns{ zs, cgh, sycl::read_only };
-			cgh.parallel_for(sycl::range<3>{ height, width, roots.size() }, [=](sycl::id<3> id) {
-				drw[id] = dist_squared(azns[sycl::id<2>{ id.get(0), id.get(1) }], rootc[id.get(2)]);
-			});
-		});
+	// Power of two no larger than the tile size, 1 disables progressive rendering
+	void updateCoarsestStride(std::size_t newS) {
+		coarsestStride = std::clamp<std::size_t>(std::bit_floor(newS), 1, tileSize & (~tileSize + 1));
+		invalidate();
+	}
 
-		queue.submit([&](sycl::handler& cgh) {
-			sycl::accessor crw{ closestRoot, cgh, sycl::write_only, sycl::no_init };
-			sycl::accessor adr{ disroot, cgh, sycl::read_only };
-			cgh.parallel_for(sycl::range<2>{ height, width }, [=](sycl::id<2> id) {
-				crw[id] = 0;
-				for (int i = 1; i < (int)rootc.size(); ++i) {
-					crw[id] = adr[sycl::id<3>(id[0], id[1], i)] <
-								  adr[sycl::id<3>(id[0], id[1], crw[id])] ?
-							  i :
-							  crw[id];
-				}
-			});
-		});
+	void updateSubdivision(bool enable) {
+		subdivision = enable;
+		invalidate();
+	}
+
+	// While enabled, views are computed at 1/previewStride resolution only, without subdivision nor anti-aliasing,
+	// and views requested while a preview is running are coalesced. Made for interactive edits: disabling it
+	// computes the current view at full quality.
+	void updatePreview(bool enable) {
+		if (preview && !enable)
+			invalidate();
+		preview = enable;
+	}
+
+	// Power of two, the samples of a preview fill blocks of previewStride x previewStride pixels
+	void updatePreviewStride(std::size_t newS) {
+		previewStride = std::bit_floor(std::max<std::size_t>(newS, 1));
+		if (preview)
+			invalidate();
+	}
+
+	// Auto switches between precisions as the view is zoomed in and out
+	void updatePrecision(Precision newP) {
+		precision = newP;
+		invalidate();
+	}
+
+	// The SIMD engine computes float and double frames on the host, double-double ones still use SYCL
+	void updateEngine(Engine newE) {
+		engine = newE;
+		invalidate();
+	}
 
-		try {
-			queue.wait_and_throw();
-		} catch (sycl::exception const& e) {
-			std::cout << "Caught synchronous SYCL exception:\n" << e.what() << std::endl;
+	// Halley and Householder converge in fewer iterations but each one costs more, see Method
+	void updateMethod(Method newM) {
+		method = newM;
+		invalidate();
+	}
+
+	// Newton steps are multiplied by this factor with Method::Relaxed
+	void updateRelaxation(comp<T> const& newR) {
+		relaxation = newR;
+		if (method == Method::Relaxed)
+			invalidate();
+	}
+
+	// Pixels on a basin boundary get up to samples samples on a square grid, 1 disables anti-aliasing
+	void updateAntialiasing(std::size_t samples) {
+		if (samples == 0 || samples > MAX_SAMPLES)
+			throw std::invalid_argument("Anti-aliasing takes between 1 and " + std::to_string(MAX_SAMPLES) +
+						    " samples per pixel");
+		aaGrid = 1;
+		while ((aaGrid + 1) * (aaGrid + 1) <= samples)
+			++aaGrid;
+		aaPixels.clear();
+		aaRoots.clear();
+		aaShades.clear();
+		invalidate();
+	}
+
+	// Memory kept for complete frames, 4 bytes per pixel and 2 per anti-aliasing sample each; 0 disables the cache
+	void updateCacheCapacity(std::size_t bytes) { frameCache.updateCapacity(bytes); }
+	void clearCache() { frameCache.clear(); }
+
+	std::size_t getTileSize() const { return tileSize; }
+	bool getSubdivision() const { return subdivision; }
+	bool getPreview() const { return preview; }
+	std::size_t getPreviewStride() const { return previewStride; }
+	Precision getPrecision() const { return precision; }
+	// Precision used by the current frame
+	Precision getKernelPrecision() const { return framePrecision; }
+	Engine getEngine() const { return engine; }
+	Method getMethod() const { return method; }
+	comp<T> const& getRelaxation() const { return relaxation; }
+	std::size_t getDeviceCount() const { return devices.size(); }
+	// Fraction of the rows of the current frame in the band of each device, tiles may still be stolen by others
+	std::vector<double> getDeviceShares() const {
+		std::vector<double> ret;
+		std::size_t prev = 0;
+		for (auto end : bandEnds) {
+			ret.push_back(static_cast<double>(end - prev) / static_cast<double>(height));
+			prev = end;
 		}
+		return ret;
+	}
+	// Samples per second of each device, measured on the previous frames, 0 if not measured yet
+	std::vector<double> getDeviceThroughputs() const {
+		std::vector<double> ret;
+		for (auto const& d : devices)
+			ret.push_back(d.throughput);
+		return ret;
+	}
+	// Engine used by the current frame
+	Engine getKernelEngine() const { return frameEngine; }
+	std::size_t getCoarsestStride() const { return coarsestStride; }
+	// Stride of the finest refinement level fully displayed, 0 if none is complete yet
+	std::size_t getDisplayedStride() const {
+		std::size_t ret = 0;
+		for (std::size_t l = 0; l < levelStrides.size() && levelTilesLeft[l] == 0; ++l)
+			ret = levelStrides[l];
+		return ret;
+	}
+	// Samples of a supersampled pixel, 1 without anti-aliasing
+	std::size_t getAntialiasing() const { return aaGrid * aaGrid; }
+	// Pixels on a basin boundary in the current frame, known once the rest of the frame is done
+	std::size_t getSupersampledPixels() const { return aaPixels.size(); }
+	std::size_t getCacheHits() const { return frameCache.getHits(); }
+	std::size_t getCacheMisses() const { return frameCache.getMisses(); }
+	std::size_t getCachedFrames() const { return frameCache.getSize(); }
+	std::size_t getCacheUsed() const { return frameCache.getUsed(); }
+	std::size_t getCacheCapacity() const { return frameCache.getCapacity(); }
+	std::size_t getTilesTotal() const { return tilesTotal; }
+	std::size_t getTilesDone() const { return tilesDone; }
+	bool isFrameComplete() const { return !needCompute && !frameRunning; }
 
-		auto end = std::chrono::high_resolution_clock::now();
-		auto elapsed = end - start;
-		auto elapsed_sec = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / 1e9;
-		static constexpr auto FLOPS_PER_ITEM_PER_ITER =
-			(N + 1) * N + N + N * (N - 1) + N - 1 + 2 + (3 * (N - 1)) + ((N - 1) - 1);
-		auto nb_flop = FLOPS_PER_ITEM_PER_ITER * (width * height) * cycles;
-		auto flops = nb_flop / elapsed_sec;
+	// Non-blocking step of the tile scheduler: starts a new frame if the view changed, collects the
+	// finished tiles and submits new ones. Returns the parts of the frame updated since the last call.
+	std::vector<Region> poll() {
+		if (needCompute && !waitingForPreview())
+			startFrame();
 
-		lastTimePerComputation = elapsed_sec;
-		lastFLOPS = flops;
+		std::erase_if(cancelledTiles, [&](Tile& t) {
+			if (!isFinished(t))
+				return false;
+			devices[t.dev].freeOutputs.push_back(std::move(t.out));
+			return true;
+		});
+		std::erase_if(cancelledBatches, [&](PixelBatch& b) {
+			if (!isFinished(b))
+				return false;
+			devices[b.dev].freeOutputs.push_back(std::move(b.out));
+			return true;
+		});
+		auto passDone = std::all_of(runningBatches.begin(), runningBatches.end(),
+					    [](auto const& b) { return isFinished(b); });
+		if (!runningBatches.empty() && passDone) {
+			if (subdivider)
+				collectPass();
+			else
+				collectSupersampling();
+		}
+		// a sample of a coarse level fills a block, so it can't overwrite the finer ones computed elsewhere
+		std::erase_if(runningTiles, [&](Tile& t) {
+			if (!isFinished(t) || !coarserLevelsDone(t.job.level))
+				return false;
+			collectTile(t);
+			return true;
+		});
+		if (needCompute && !waitingForPreview())
+			startFrame();
+		for (std::size_t d = 0; d < bandEnds.size() && !needCompute; ++d) {
+			auto& dev = devices[d];
+			auto busy = std::count_if(runningTiles.begin(), runningTiles.end(),
+						  [&](Tile const& t) { return t.dev == d && !isFinished(t); });
+			for (; static_cast<std::size_t>(busy) < tilesInFlight() &&
+			       (!dev.pending.empty() || stealTile(d));
+			     ++busy) {
+				runningTiles.push_back(submitTile(dev.pending.front(), d));
+				dev.pending.pop_front();
+			}
+		}
+		if (frameRunning && !needCompute && pendingTiles() == 0 && runningTiles.empty() &&
+		    runningBatches.empty() && (aaDone || !startSupersampling()))
+			finishFrame();
 
-		auto ha = closestRoot.get_host_access(sycl::read_only);
-		std::copy(ha.begin(), ha.end(), cache.begin());
-		needCompute = false;
+		return std::exchange(finishedRegions, {});
+	}
+
+	// Blocks until the current view is fully computed
+	std::vector<std::uint8_t> const& compute() {
+		using namespace cl;
+		//return std::mdspan(cache.data(), height, width);
+		do {
+			poll();
+			waitForTask();
+			try {
+				for (auto& d : devices)
+					d.queue.wait_and_throw();
+			} catch (sycl::exception const& e) {
+				std::cerr << "Caught synchronous SYCL exception:\n" << e.what() << std::endl;
+			}
+		} while (!isFrameComplete());
 		return cache;
 	}
 };
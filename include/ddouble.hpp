@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+// Double-double: the unevaluated sum hi + lo of two doubles, |lo| <= ulp(hi) / 2, about 32 significant digits.
+// Only uses double operations so it also runs on devices without any wider type.
+class ddouble {
+	// error-free transformations, s + e is exactly a + b (resp. a * b)
+	static constexpr ddouble twoSum(double a, double b) {
+		auto s = a + b;
+		auto bb = s - a;
+		return { s, (a - (s - bb)) + (b - bb) };
+	}
+	// requires |a| >= |b|
+	static constexpr ddouble quickTwoSum(double a, double b) {
+		auto s = a + b;
+		return { s, b - (s - a) };
+	}
+	// a = hi + lo, both on 26 bits at most so that their products are exact (Dekker's split)
+	static constexpr ddouble split(double a) {
+		constexpr double SPLITTER = 134217729.; // 2^27 + 1
+		auto t = SPLITTER * a;
+		auto hi = t - (t - a);
+		return { hi, a - hi };
+	}
+	// std::fma is not constexpr in every standard library, constant expressions use Dekker's product instead
+	static constexpr ddouble twoProd(double a, double b) {
+		auto p = a * b;
+		if consteval {
+			auto x = split(a);
+			auto y = split(b);
+			return { p, ((x.hi * y.hi - p) + x.hi * y.lo + x.lo * y.hi) + x.lo * y.lo };
+		} else {
+			return { p, std::fma(a, b, -p) };
+		}
+	}
+
+    public:
+	double hi, lo;
+
+	constexpr ddouble(double hi_ = 0.) : hi{ hi_ }, lo{ 0. } {}
+	constexpr ddouble(double hi_, double lo_) : hi{ hi_ }, lo{ lo_ } {}
+
+	explicit constexpr operator double() const { return hi + lo; }
+	explicit constexpr operator float() const { return static_cast<float>(hi + lo); }
+
+	constexpr ddouble operator-() const { return { -hi, -lo }; }
+
+	constexpr ddouble& operator+=(ddouble const& oth) {
+		auto s = twoSum(hi, oth.hi);
+		auto t = twoSum(lo, oth.lo);
+		s.lo += t.hi;
+		s = quickTwoSum(s.hi, s.lo);
+		s.lo += t.lo;
+		*this = quickTwoSum(s.hi, s.lo);
+		return *this;
+	}
+	friend constexpr ddouble operator+(ddouble lhs, ddouble const& rhs) {
+		lhs += rhs;
+		return lhs;
+	}
+	constexpr ddouble& operator-=(ddouble const& oth) { return *this += -oth; }
+	friend constexpr ddouble operator-(ddouble lhs, ddouble const& rhs) {
+		lhs -= rhs;
+		return lhs;
+	}
+
+	constexpr ddouble& operator*=(ddouble const& oth) {
+		auto p = twoProd(hi, oth.hi);
+		p.lo += hi * oth.lo + lo * oth.hi;
+		*this = quickTwoSum(p.hi, p.lo);
+		return *this;
+	}
+	friend constexpr ddouble operator*(ddouble lhs, ddouble const& rhs) {
+		lhs *= rhs;
+		return lhs;
+	}
+
+	// long division, each quotient digit is a double
+	constexpr ddouble& operator/=(ddouble const& oth) {
+		auto q1 = hi / oth.hi;
+		auto r = *this - oth * ddouble{ q1 };
+		auto q2 = r.hi / oth.hi;
+		r -= oth * ddouble{ q2 };
+		auto q3 = r.hi / oth.hi;
+		*this = quickTwoSum(q1, q2) + ddouble{ q3 };
+		return *this;
+	}
+	friend constexpr ddouble operator/(ddouble lhs, ddouble const& rhs) {
+		lhs /= rhs;
+		return lhs;
+	}
+
+	friend constexpr bool operator==(ddouble const& lhs, ddouble const& rhs) {
+		return lhs.hi == rhs.hi && lhs.lo == rhs.lo;
+	}
+	friend constexpr bool operator<(ddouble const& lhs, ddouble const& rhs) {
+		return lhs.hi < rhs.hi || (lhs.hi == rhs.hi && lhs.lo < rhs.lo);
+	}
+	friend constexpr bool operator>(ddouble const& lhs, ddouble const& rhs) { return rhs < lhs; }
+	friend constexpr bool operator<=(ddouble const& lhs, ddouble const& rhs) { return !(rhs < lhs); }
+	friend constexpr bool operator>=(ddouble const& lhs, ddouble const& rhs) { return !(lhs < rhs); }
+
+	// Printed with the precision of a double
+	template <typename O>
+	friend O& operator<<(O& os, ddouble const& v) {
+		os << static_cast<double>(v);
+		return os;
+	}
+};
+
+template <>
+struct std::numeric_limits<ddouble> {
+	static constexpr bool is_specialized = true;
+	static constexpr int digits = 2 * std::numeric_limits<double>::digits;
+	static constexpr ddouble epsilon() { return ddouble{ 4.93038065763132e-32 }; } // 2^-104
+	static constexpr ddouble min() { return ddouble{ std::numeric_limits<double>::min() }; }
+	static constexpr ddouble max() { return ddouble{ std::numeric_limits<double>::max() }; }
+	static constexpr ddouble lowest() { return ddouble{ std::numeric_limits<double>::lowest() }; }
+	static constexpr ddouble infinity() { return ddouble{ std::numeric_limits<double>::infinity() }; }
+};
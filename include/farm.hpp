@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "image.hpp"
+
+// Horizontal band of the final image, the unit of work of the render farm
+struct Band {
+	std::uint32_t id;
+	std::uint32_t y; // first row in the image
+	std::uint32_t h;
+};
+
+// Bands of bandHeight rows (less for the last one) covering height rows, top to bottom
+std::vector<Band> splitRows(std::size_t height, std::size_t bandHeight);
+
+// Protocol between the coordinator and its workers, over pipes of the same host so integers are sent in native
+// byte order. The coordinator sends a band (h == 0 asks the worker to exit), the worker answers with the same
+// band followed by its width * h pixels. Every function throws if the other side is gone.
+void sendBand(int fd, Band const& b);
+// false if the stream was closed before a band started
+bool receiveBand(int fd, Band& b);
+void sendPixels(int fd, Rgba const* pixels, std::size_t n);
+void receivePixels(int fd, Rgba* pixels, std::size_t n);
+
+// Worker side: renders the bands read from in and sends them on out, until asked to exit or in is closed
+void serveBands(int in, int out, std::size_t width, std::function<void(Band const&, Rgba*)> const& render);
+
+struct FarmOptions {
+	std::vector<std::string> workerCommand; // program and arguments starting a worker
+	std::size_t workers;
+	std::size_t maxAttempts; // of a band, before the whole render fails
+	std::chrono::milliseconds bandTimeout; // a worker still rendering a band after that long is considered stalled
+};
+
+// Coordinator side: renders bands with local worker processes. A worker which crashes, closes its pipe or stalls
+// past the band timeout is replaced and its band given again. sink receives the rows top to bottom as soon as they
+// are contiguous, at most 2 bands per worker are kept in memory.
+void runFarm(FarmOptions const& opts, std::size_t width, std::vector<Band> const& bands,
+	     std::function<void(Rgba const*, std::size_t)> const& sink);
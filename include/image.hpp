@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+struct Rgba {
+	std::uint8_t r, g, b, a;
+};
+
+// Red, green and blue for the first three roots, evenly spaced hues after that
+std::vector<Rgba> defaultPalette(std::size_t n);
+
+// levels shades of each color of palette, level l of color c at index c * levels + l. Brightness goes from 1 down
+// to 0.15 as 0.15 + 0.85 * exp(-l / decay), a decay of 0 keeps every level at the color itself.
+std::vector<Rgba> shadeTable(std::vector<Rgba> const& palette, std::size_t levels, double decay);
+
+// Binary PPM (P6), alpha is dropped
+void writePpm(std::ostream& os, std::size_t width, std::size_t height, Rgba const* pixels);
+void writePpmHeader(std::ostream& os, std::size_t width, std::size_t height);
+void writePpmRows(std::ostream& os, std::size_t width, std::size_t rows, Rgba const* pixels);
+
+// Streams an 8 bits RGB PNG: rows are compressed and written as soon as they are given,
+// so the whole image never has to be in memory
+class PngWriter {
+	std::ostream& os;
+	std::size_t width;
+	std::size_t height;
+	std::size_t rows;
+	z_stream zs;
+	std::vector<unsigned char> row;
+	std::vector<unsigned char> out;
+	bool finished;
+
+	void writeChunk(char const* type, unsigned char const* data, std::size_t size);
+	void deflateRow(int flush);
+
+    public:
+	PngWriter(std::ostream& os_, std::size_t width_, std::size_t height_);
+	PngWriter(PngWriter const&) = delete;
+	PngWriter& operator=(PngWriter const&) = delete;
+	~PngWriter();
+
+	void writeRow(Rgba const* pixels);
+	void writeRows(Rgba const* pixels, std::size_t n);
+	// Called by the destructor if needed, throws if some rows are missing
+	void finish();
+};
+
+// Streams rows to a PNG or a PPM file depending on the extension of path, top to bottom
+class ImageWriter {
+	std::string path;
+	std::ofstream ofs;
+	std::optional<PngWriter> png;
+	std::size_t width;
+	std::size_t height;
+	std::size_t rows;
+
+    public:
+	ImageWriter(std::string const& path_, std::size_t width_, std::size_t height_);
+
+	void writeRows(Rgba const* pixels, std::size_t n);
+	// Throws if some rows are missing or could not be written
+	void finish();
+};
+
+// Uncompressed YUV4MPEG2 video (4:4:4, BT.601 studio range), read by ffmpeg and most encoders from a pipe
+class Y4mWriter {
+	std::ostream& os;
+	std::size_t width;
+	std::size_t height;
+	std::vector<unsigned char> planes;
+
+    public:
+	Y4mWriter(std::ostream& os_, std::size_t width_, std::size_t height_, unsigned fps);
+
+	void writeFrame(Rgba const* pixels);
+};
+
+// Writes a PNG or a PPM depending on the extension of path
+void writeImage(std::string const& path, std::size_t width, std::size_t height, Rgba const* pixels);
@@ -3,14 +3,16 @@
 #include <vector>
 #include <memory>
 #include <format>
+#include <optional>
 
 #include <SFML/Graphics.hpp>
 
 #include "compute.hpp"
+#include "view.hpp"
 
-template <typename T, int N>
+template <typename T>
 class Interface {
-	std::shared_ptr<FractalComputer<T, N>> computer;
+	std::shared_ptr<FractalComputer<T>> computer;
 
 	sf::RenderWindow window;
 	sf::Texture texture;
@@ -19,18 +21,24 @@ class Interface {
 	std::vector<sf::Text> infoTexts;
 	sf::RectangleShape infoRect;
 
-	std::vector<unsigned char> pix;
-	std::vector<sf::Color> color_map;
-
 	bool showInfos;
 
+	// Roots are edited by dragging their markers, the frame is previewed until the mouse button is released
+	bool showRoots;
+	RootDrag<T> drag;
+	sf::CircleShape rootMarker;
+
+	// the computer only knows its own stages, colorization and upload are added here
+	FrameStats stats;
+	std::optional<FrameStatsLog> statsLog;
+
+	static constexpr float ROOT_MARKER_RADIUS = 8.f;
     public:
-	Interface(std::shared_ptr<FractalComputer<T, N>> computer_, std::size_t fpsLimit = 60,
+	Interface(std::shared_ptr<FractalComputer<T>> computer_, std::size_t fpsLimit = 60,
 		  std::vector<sf::Color> const& cmap = { { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 } })
 		: computer{ computer_ },
 		  window{ sf::VideoMode(computer->getWidth(), computer->getHeight()), "Newton fractal viewer" },
-		  infoTexts{ 5 }, pix(computer->getWidth() * computer->getHeight() * 4), color_map{ cmap },
-		  showInfos{ false } {
+		  infoTexts{ 14 }, showInfos{ false }, showRoots{ true }, rootMarker{ ROOT_MARKER_RADIUS } {
 		window.setFramerateLimit(fpsLimit);
 		texture.create(computer->getWidth(), computer->getHeight());
 		sprite = sf::Sprite{ texture };
@@ -38,22 +46,40 @@ class Interface {
 			throw std::runtime_error("Could not load font!");
 		}
 		infoRect.setFillColor({ 128, 128, 128, 150 }); // grey
+		rootMarker.setOrigin(ROOT_MARKER_RADIUS, ROOT_MARKER_RADIUS);
+		rootMarker.setFillColor(sf::Color::Transparent);
+		rootMarker.setOutlineColor(sf::Color::White);
+		rootMarker.setOutlineThickness(2.f);
+
+		std::vector<Rgba> palette;
+		for (auto const& c : cmap)
+			palette.push_back({ c.r, c.g, c.b, c.a });
+		computer->updatePalette(palette);
 	}
 
-	std::weak_ptr<FractalComputer<T, N>> getComputer() const { return computer; }
+	std::weak_ptr<FractalComputer<T>> getComputer() const { return computer; }
 
+	// Statistics of the frame being displayed, including the texture upload
+	FrameStats const& getFrameStats() const { return stats; }
+	// Every completed frame is appended to path, as CSV or JSON lines depending on its extension
+	void logFrameStats(std::string const& path) { statsLog.emplace(path); }
+
+	// Never blocks on the computer, the texture is only updated when some tiles were finished since the last call
+	// Pixels are colored by the device, the texture is uploaded straight from the computer's host memory
 	void updateSprite() {
-		auto const& outVec = computer->compute();
-		for (std::size_t i = 0; i < outVec.size(); ++i) {
-			auto idx = i * 4;
-			auto const r = outVec[i];
-			auto const& col = color_map[r];
-			pix[idx + 0] = col.r;
-			pix[idx + 1] = col.g;
-			pix[idx + 2] = col.b;
-			pix[idx + 3] = col.a;
-		}
-		texture.update(pix.data());
+		static_assert(sizeof(Rgba) == 4, "colors are uploaded as RGBA bytes");
+		if (computer->poll().empty())
+			return;
+
+		auto upload = computer->getFrameStats().frame == stats.frame ? stats.upload : 0.;
+		auto start = std::chrono::steady_clock::now();
+		texture.update(reinterpret_cast<sf::Uint8 const*>(computer->getColors()));
+		upload += secondsSince(start);
+
+		stats = computer->getFrameStats();
+		stats.upload = upload;
+		if (stats.complete && statsLog)
+			statsLog->write(stats);
 	}
 
 	void toggleInformations() { showInfos = !showInfos; }
@@ -64,6 +90,14 @@ class Interface {
 			/*} else if (event.type == sf::Event::Resized) {
 			computer->updateWidth(event.size.width);
 			computer->updateHeight(event.size.height);*/ // buffer are not easily resizable
+		} else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+			if (showRoots)
+				drag.press(*computer, event.mouseButton.x, event.mouseButton.y);
+		} else if (event.type == sf::Event::MouseMoved) {
+			drag.move(*computer, event.mouseMove.x, event.mouseMove.y);
+		} else if (event.type == sf::Event::MouseButtonReleased &&
+			   event.mouseButton.button == sf::Mouse::Left) {
+			drag.release(*computer);
 		} else if (event.type == sf::Event::KeyPressed) {
 			if (event.key.code == sf::Keyboard::Escape) {
 				window.close();
@@ -91,20 +125,82 @@ class Interface {
 				}
 			} else if (event.key.code == sf::Keyboard::I) {
 				toggleInformations();
+			} else if (event.key.code == sf::Keyboard::S) {
+				computer->updateSubdivision(!computer->getSubdivision());
+			} else if (event.key.code == sf::Keyboard::P) {
+				// auto, float, double, double-double and back to auto
+				auto next = (static_cast<int>(computer->getPrecision()) + 1) %
+					    (static_cast<int>(Precision::Auto) + 1);
+				computer->updatePrecision(static_cast<Precision>(next));
+			} else if (event.key.code == sf::Keyboard::E) {
+				computer->updateEngine(computer->getEngine() == Engine::Sycl ? Engine::Simd
+											       : Engine::Sycl);
+			} else if (event.key.code == sf::Keyboard::A) {
+				// 1, 4 and 16 samples per boundary pixel
+				auto samples = computer->getAntialiasing();
+				computer->updateAntialiasing(samples >= 16 ? 1 : 4 * samples);
+			} else if (event.key.code == sf::Keyboard::H) {
+				computer->updateShading(computer->getShading() == Shading::Flat ? Shading::Smooth
+												  : Shading::Flat);
+			} else if (event.key.code == sf::Keyboard::R) {
+				showRoots = !showRoots;
+			} else if (event.key.code == sf::Keyboard::M) {
+				// newton, halley, householder, relaxed and back to newton
+				auto next = (static_cast<int>(computer->getMethod()) + 1) %
+					    (static_cast<int>(Method::Relaxed) + 1);
+				computer->updateMethod(static_cast<Method>(next));
 			}
 		}
 	}
 
-	std::array<std::string, 5> infoStrings() const {
-		std::array<std::string, 5> ret;
+	std::array<std::string, 14> infoStrings() const {
+		std::array<std::string, 14> ret;
 		ret[0] = std::format("FLOPS: {:.2e}", computer->getFLOPS());
 		ret[1] = std::format("s/it: {:.2f}", computer->getIterTime());
-		ret[2] = std::format("center: ({:.4f}{:+.4f}i)", computer->getCenter().re, computer->getCenter().im);
-		ret[3] = std::format("resolution: {:.2e}", computer->getIncrement());
+		ret[2] = std::format("center: ({:.4f}{:+.4f}i)", static_cast<double>(computer->getCenter().re),
+				     static_cast<double>(computer->getCenter().im));
+		ret[3] = std::format("resolution: {:.2e}", static_cast<double>(computer->getIncrement()));
 		ret[4] = std::format("cycles: {:d}", computer->getCycles());
+		ret[5] = std::format("tiles: {:d}/{:d}", computer->getTilesDone(), computer->getTilesTotal());
+		// no level is complete yet at the start of a frame
+		auto stride = computer->getDisplayedStride();
+		ret[6] = stride > 0 ? std::format("level: 1/{:d}", stride) : std::string{ "level: -" };
+		ret[7] = std::format("precision: {} ({})", precisionName(computer->getKernelPrecision()),
+				     precisionName(computer->getPrecision()));
+		ret[8] = computer->getKernelEngine() == Engine::Simd
+				 ? std::format("engine: simd ({})", simdIsaName(bestSimdIsa()))
+				 : std::format("engine: {}", engineName(computer->getKernelEngine()));
+		ret[9] = std::format("devices: {:d} (", computer->getDeviceCount());
+		for (auto share : computer->getDeviceShares())
+			ret[9] += std::format(" {:.0f}%", 100. * share);
+		ret[9] += " )";
+		ret[10] = std::format("cache: {:d} hits, {:d} misses, {:d} frames ({:.0f}/{:.0f} MB)",
+				      computer->getCacheHits(), computer->getCacheMisses(), computer->getCachedFrames(),
+				      static_cast<double>(computer->getCacheUsed()) / (1 << 20),
+				      static_cast<double>(computer->getCacheCapacity()) / (1 << 20));
+		ret[11] = computer->getAntialiasing() > 1
+				  ? std::format("antialiasing: {:d} samples on {:d} pixels",
+						computer->getAntialiasing(), computer->getSupersampledPixels())
+				  : "antialiasing: off";
+		ret[12] = std::format("shading: {}", shadingName(computer->getShading()));
+		ret[13] = std::format("method: {}", methodName(computer->getMethod()));
+		if (computer->getMethod() == Method::Relaxed)
+			ret[13] += std::format(" ({:.2f}{:+.2f}i)", static_cast<double>(computer->getRelaxation().re),
+					       static_cast<double>(computer->getRelaxation().im));
 		return ret;
 	}
 
+	void drawRoots() {
+		if (!showRoots)
+			return;
+		auto view = viewMapping(*computer);
+		for (auto const& r : drag.roots(*computer)) {
+			auto p = view.toPixel(r);
+			rootMarker.setPosition(p.x, p.y);
+			window.draw(rootMarker);
+		}
+	}
+
 	void drawInfos(float spacing = 10.f) {
 		if (!showInfos)
 			return;
@@ -135,10 +231,12 @@ class Interface {
 			while (window.pollEvent(event)) {
 				handleEvent(event);
 			}
+			drag.apply(*computer);
 
 			updateSprite();
 			window.clear();
 			window.draw(sprite);
+			drawRoots();
 			drawInfos();
 			window.display();
 		}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "comp.hpp"
+#include "poly.hpp"
+
+// Newton's method works on any polynomial P providing apply_with_derivative (Polynome or PolyView), the higher
+// order methods also need apply_with_derivatives
+
+// Iteration methods, the kernels are compiled for each of them:
+// - Newton, z - u with u = p / p'
+// - Halley, z - u / (1 - u p'' / 2p'), cubic convergence
+// - Householder, the third order method z - u (1 + u p'' / 2p') (also known as Chebyshev's), cubic convergence
+// - Relaxed, Newton's step multiplied by a complex factor, which twists and merges the basins
+enum class Method { Newton, Halley, Householder, Relaxed };
+
+constexpr char const* methodName(Method m) {
+	switch (m) {
+	case Method::Newton:
+		return "newton";
+	case Method::Halley:
+		return "halley";
+	case Method::Householder:
+		return "householder";
+	default:
+		return "relaxed";
+	}
+}
+
+// Order of convergence to a simple root, relaxed Newton is only quadratic with a factor of 1
+constexpr int convergenceOrder(Method m) {
+	return m == Method::Halley || m == Method::Householder ? 3 : 2;
+}
+
+template <typename T>
+struct NewtonResult {
+	comp<T> z;
+	int iters;
+};
+
+// Iterates method M until |p(z)| or the step size drops below tolerance, at most cycles times. p, p' and p'' are
+// evaluated in a single pass, only when the method needs them. relaxation is only used by Method::Relaxed.
+// A pixel stalled on a critical point, or where the step is not defined, reports cycles iterations as it never
+// converges.
+template <Method M, typename P, typename T>
+constexpr NewtonResult<T> methodConverge(P const& p, comp<T> z, int cycles, T tolerance,
+					 comp<T> const& relaxation = comp<T>{ 1. }) {
+	for (int i = 0; i < cycles; ++i) {
+		comp<T> step;
+		if constexpr (M == Method::Newton || M == Method::Relaxed) {
+			auto e = p.apply_with_derivative(z);
+			if (e.p.is_zero(tolerance))
+				return { z, i };
+			if (e.dp.is_zero())
+				return { z, cycles };
+			step = e.p / e.dp;
+			if constexpr (M == Method::Relaxed)
+				step = relaxation * step;
+		} else {
+			auto e = p.apply_with_derivatives(z);
+			if (e.p.is_zero(tolerance))
+				return { z, i };
+			if (e.dp.is_zero())
+				return { z, cycles };
+			auto u = e.p / e.dp;
+			auto t = e.half_d2p / e.dp; // p'' / 2p'
+			if constexpr (M == Method::Halley) {
+				auto w = comp<T>{ 1. } - u * t;
+				if (w.is_zero())
+					return { z, cycles };
+				step = u / w;
+			} else {
+				step = u + u * (u * t);
+			}
+		}
+		z -= step;
+		if (step.is_zero(tolerance))
+			return { z, i + 1 };
+	}
+	return { z, cycles };
+}
+
+template <typename P, typename T>
+constexpr NewtonResult<T> newtonConverge(P const& p, comp<T> z, int cycles, T tolerance) {
+	return methodConverge<Method::Newton>(p, z, cycles, tolerance);
+}
+
+template <typename T>
+struct ClosestRoot {
+	int index;
+	T dist2; // squared distance to z
+};
+
+// Root closest to z, the first one on ties
+template <typename T>
+constexpr ClosestRoot<T> closestRoot(comp<T> const* roots, int n, comp<T> const& z) {
+	ClosestRoot<T> ret{ 0, dist_squared(z, roots[0]) };
+	for (int i = 1; i < n; ++i) {
+		auto d = dist_squared(z, roots[i]);
+		if (d < ret.dist2)
+			ret = { i, d };
+	}
+	return ret;
+}
+
+// Index of the root closest to z
+template <typename T>
+constexpr int closestRootIndex(comp<T> const* roots, int n, comp<T> const& z) {
+	return closestRoot(roots, n, z).index;
+}
+
+template <typename T, std::size_t R>
+constexpr int closestRootIndex(std::array<comp<T>, R> const& roots, comp<T> const& z) {
+	return closestRootIndex(roots.data(), static_cast<int>(R), z);
+}
+
+// Pixels are shaded after their fractional iteration count, SHADE_STEPS levels per Newton step. The last level
+// is kept for pixels which did not converge.
+inline constexpr int SHADE_LEVELS = 256;
+inline constexpr int SHADE_STEPS = 8;
+
+// Levels per Newton step for at most cycles steps, fewer than SHADE_STEPS when they would not fit in the levels
+constexpr float shadeSteps(int cycles) {
+	return std::min(static_cast<float>(SHADE_STEPS),
+			static_cast<float>(SHADE_LEVELS - 2) / static_cast<float>(std::max(cycles, 1)));
+}
+
+// log2 of a positive normal float, exact on powers of two and linear in between (at most 0.09 below).
+// Only integer and float operations, so every device and the host give the same result.
+constexpr float approxLog2(float x) {
+	auto bits = std::bit_cast<std::uint32_t>(x);
+	auto mantissa = std::bit_cast<float>((bits & 0x007fffffu) | 0x3f800000u); // in [1, 2)
+	return static_cast<float>(static_cast<int>(bits >> 23) - 127) + mantissa - 1.f;
+}
+
+// Shade level of the fractional iteration count iters - log_order(log d / log tolerance), d being the distance from
+// the final iterate to its root: Newton's method doubles the correct digits at each step near a simple root (order
+// 2, the cubic methods triple them), so a pixel ending far below the tolerance got there up to a step earlier than
+// its iteration count tells.
+template <typename T>
+constexpr std::uint8_t shadeLevel(int iters, int cycles, T const& dist2, T const& tolerance, int order = 2) {
+	if (iters >= cycles)
+		return SHADE_LEVELS - 1;
+	auto lt = 2.f * approxLog2(static_cast<float>(tolerance)); // log2 of tolerance squared
+	auto d = static_cast<float>(dist2);
+	auto frac = 1.f; // exactly on the root
+	if (d >= std::numeric_limits<float>::min()) {
+		auto ld = approxLog2(d);
+		frac = ld < lt && lt < 0.f ? std::min(approxLog2(ld / lt) / approxLog2(static_cast<float>(order)), 1.f)
+					   : 0.f;
+	}
+	auto level = static_cast<int>((static_cast<float>(iters) - frac) * shadeSteps(cycles));
+	return static_cast<std::uint8_t>(std::clamp(level, 0, SHADE_LEVELS - 2));
+}
+
+// Samples are placed in double at least, then rounded to the precision of the kernel. A float pixel then gets the
+// same z whether it is computed in a fresh frame or in one panned from another top left corner.
+template <typename T>
+using SampleCoord = std::conditional_t<(sizeof(T) < sizeof(double)), double, T>;
+
+struct PixelResult {
+	int root;
+	int iters;
+	std::uint8_t shade;
+};
+
+// Everything a kernel needs to compute a pixel of a view with method M
+template <typename T, int N, Method M = Method::Newton>
+struct PixelSampler {
+	Polynome<T, N> poly;
+	std::array<comp<T>, N - 1> roots;
+	comp<SampleCoord<T>> top_left;
+	SampleCoord<T> inc;
+	int cycles;
+	T tolerance;
+	comp<T> relaxation{ 1. };
+
+	constexpr PixelResult operator()(std::size_t x, std::size_t y) const {
+		auto z = comp_cast<T>(top_left + comp<SampleCoord<T>>(x * inc, y * inc));
+		auto res = methodConverge<M>(poly, z, cycles, tolerance, relaxation);
+		auto closest = closestRoot(roots.data(), N - 1, res.z);
+		return { closest.index, res.iters,
+			 shadeLevel(res.iters, cycles, closest.dist2, tolerance, convergenceOrder(M)) };
+	}
+};
+
+// PixelSampler for a degree which is only known at runtime, coefficients and roots have to be readable by the device
+template <typename T, Method M = Method::Newton>
+struct RuntimePixelSampler {
+	PolyView<T> poly;
+	comp<T> const* roots;
+	comp<SampleCoord<T>> top_left;
+	SampleCoord<T> inc;
+	int cycles;
+	T tolerance;
+	comp<T> relaxation{ 1. };
+
+	constexpr PixelResult operator()(std::size_t x, std::size_t y) const {
+		auto z = comp_cast<T>(top_left + comp<SampleCoord<T>>(x * inc, y * inc));
+		auto res = methodConverge<M>(poly, z, cycles, tolerance, relaxation);
+		auto closest = closestRoot(roots, poly.degree, res.z);
+		return { closest.index, res.iters,
+			 shadeLevel(res.iters, cycles, closest.dist2, tolerance, convergenceOrder(M)) };
+	}
+};
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "comp.hpp"
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <future>
+#include <limits>
+#include <thread>
+#include <utility>
 #include <stdexcept>
+#include <vector>
 
 template <typename T>
 constexpr T pw(T&& z, int p) {
@@ -21,27 +28,157 @@ constexpr T pw(T&& z, int p) {
 template <typename T>
 using comp_t = comp<T>;
 
+// p(z) and p'(z) evaluated together
+template <typename Real>
+struct PolyEval {
+	comp_t<Real> p;
+	comp_t<Real> dp;
+};
+
+// p(z), p'(z) and p''(z) / 2 evaluated together, Horner's scheme gives the halved second derivative
+template <typename Real>
+struct PolyEval2 {
+	comp_t<Real> p;
+	comp_t<Real> dp;
+	comp_t<Real> half_d2p;
+};
+
+// |re| + |im|, an overestimate of the modulus by at most sqrt(2) which is cheap and constexpr
+template <typename Real>
+constexpr Real norm1(comp_t<Real> const& z) {
+	return mabs(z.re) + mabs(z.im);
+}
+
+// Geometric mean of the moduli of the roots, |c_0 / c_degree|^(1 / degree), rounded up to a power of two. Roots
+// are usually spread around it, while bounds holding all of them grow far too loose with the degree; the simultaneous
+// root finders converge faster from slightly outside the roots than from inside.
+template <typename Real>
+constexpr Real meanRootRadius(comp_t<Real> const* coeffs, int degree) {
+	auto ratio = norm1(coeffs[0]) / norm1(coeffs[degree]);
+	auto power = [degree](Real r) {
+		Real ret{ 1. };
+		for (int i = 0; i < degree; ++i)
+			ret *= r;
+		return ret;
+	};
+	Real r{ 1. };
+	for (int k = 0; k < 1024 && power(r) < ratio; ++k)
+		r *= Real{ 2. };
+	for (int k = 0; k < 1024 && !(power(r / Real{ 2. }) < ratio); ++k)
+		r /= Real{ 2. };
+	return r;
+}
+
+// Distinct starting points for the simultaneous root finders, on a circle of the given radius around center. Their
+// angles are multiples of an irrational number of turns starting off the real axis, so they neither repeat nor
+// start on a symmetry of the polynomial.
+template <typename Real>
+constexpr void spreadStartingPoints(comp_t<Real>* z, int n, comp_t<Real> const& center, Real radius) {
+	comp_t<Real> const turn{ 0.6, 0.8 }; // a unit step of about 0.148 turn
+	comp_t<Real> s{ Real{ 0.28 } * radius, Real{ 0.96 } * radius };
+	for (int i = 0; i < n; ++i) {
+		z[i] = center + s;
+		s *= turn;
+	}
+}
+
+// Refines the approximations z of the degree roots of a polynomial all at once (Aberth-Ehrlich): each one takes a
+// Newton step corrected by the repulsion of the others, so two of them never settle on the same simple root and no
+// deflation is needed. Converges cubically to simple roots, linearly to multiple ones.
+// A root stops moving once p is below the rounding error of its evaluation, or its step below tolerance relative
+// to it. True once every root has stopped, false if max_iters iterations were not enough.
+template <typename Real>
+constexpr bool aberthRefine(comp_t<Real> const* coeffs, int degree, comp_t<Real>* z, std::size_t max_iters,
+			    Real tolerance) {
+	comp_t<Real> const one{ 1. };
+	auto const roundoff = Real{ 8. } * std::numeric_limits<Real>::epsilon();
+	for (std::size_t it = 0; it < max_iters; ++it) {
+		auto converged = true;
+		for (int i = 0; i < degree; ++i) {
+			// Horner pass for p, p' and the bound of the rounding error of p, sum |c_k| |z|^k
+			comp_t<Real> p = coeffs[degree], dp{};
+			auto bound = norm1(p);
+			auto az = norm1(z[i]);
+			for (int k = degree - 1; k >= 0; --k) {
+				dp = dp * z[i] + p;
+				p = p * z[i] + coeffs[k];
+				bound = bound * az + norm1(coeffs[k]);
+			}
+			// p within its rounding error: the step is noise, but it still polishes roots computed exactly
+			auto settled = !(norm1(p) > roundoff * bound);
+			comp_t<Real> repulsion{};
+			for (int j = 0; j < degree; ++j) {
+				auto d = z[i] - z[j];
+				if (j != i && !d.is_zero())
+					repulsion += one / d;
+			}
+			// p / (p' - p * repulsion), the Newton step p / p' corrected by the other roots
+			auto denom = dp - p * repulsion;
+			if (denom.is_zero()) {
+				converged = converged && settled;
+				continue;
+			}
+			auto step = p / denom;
+			z[i] -= step;
+			auto small = !(dist_squared(step, comp_t<Real>{}) >
+				       tolerance * tolerance * dist_squared(z[i], comp_t<Real>{}));
+			converged = converged && (settled || small);
+		}
+		if (converged)
+			return true;
+	}
+	return false;
+}
+
 template <class Real, int N>
 class Polynome {
+	// Horner's scheme, unrolled at compile time from the highest coefficient down
+	template <std::size_t... I>
+	constexpr comp_t<Real> horner(comp_t<Real> const& z, std::index_sequence<I...>) const {
+		auto ret = coeffs_[N - 1];
+		((ret = ret * z + coeffs_[N - 2 - I]), ...);
+		return ret;
+	}
+
+	template <std::size_t... I>
+	constexpr PolyEval<Real> horner_with_derivative(comp_t<Real> const& z, std::index_sequence<I...>) const {
+		PolyEval<Real> ret{ coeffs_[N - 1], comp_t<Real>{} };
+		((ret.dp = ret.dp * z + ret.p, ret.p = ret.p * z + coeffs_[N - 2 - I]), ...);
+		return ret;
+	}
+
+	template <std::size_t... I>
+	constexpr PolyEval2<Real> horner_with_derivatives(comp_t<Real> const& z, std::index_sequence<I...>) const {
+		PolyEval2<Real> ret{ coeffs_[N - 1], comp_t<Real>{}, comp_t<Real>{} };
+		((ret.half_d2p = ret.half_d2p * z + ret.dp, ret.dp = ret.dp * z + ret.p,
+		  ret.p = ret.p * z + coeffs_[N - 2 - I]),
+		 ...);
+		return ret;
+	}
+
     public:
 	constexpr Polynome(std::array<comp_t<Real>, N>&& coeffs) : coeffs_(coeffs) {}
 
 	constexpr comp_t<Real> apply_coeff(comp_t<Real> z, std::size_t idx) const {
-		return idx > 0 ? pw(coeffs_[idx] * z, idx) : coeffs_[idx];
+		return idx > 0 ? coeffs_[idx] * pw(std::move(z), idx) : coeffs_[idx];
 	}
 
-	constexpr comp_t<Real> apply(comp_t<Real> z) const {
-		decltype(z) ret = 0.f;
-		for (int i = 0; i < N; ++i) {
-			ret += apply_coeff(z, i);
-		}
-		return ret;
+	constexpr comp_t<Real> apply(comp_t<Real> z) const { return horner(z, std::make_index_sequence<N - 1>{}); }
+
+	// Single Horner pass computing both p(z) and p'(z)
+	constexpr PolyEval<Real> apply_with_derivative(comp_t<Real> z) const {
+		return horner_with_derivative(z, std::make_index_sequence<N - 1>{});
+	}
+
+	// p, p' and p'' / 2 in a single pass
+	constexpr PolyEval2<Real> apply_with_derivatives(comp_t<Real> z) const {
+		return horner_with_derivatives(z, std::make_index_sequence<N - 1>{});
 	}
 
 	constexpr Polynome<Real, N - 1> derivative() const {
 		std::array<comp_t<Real>, N - 1> arr;
 		for (std::size_t i = 0; i < N - 1; ++i) {
-			arr[i] = coeffs_[i + 1] * static_cast<Real>(i + 2);
+			arr[i] = coeffs_[i + 1] * static_cast<Real>(i + 1);
 		}
 		return Polynome<Real, N - 1>{ std::move(arr) };
 	}
@@ -57,53 +194,23 @@ class Polynome {
 		return ret;
 	}
 
+	// Every root at once (see aberthRefine), starting on a circle around z0. Zero roots are factored out exactly
+	// first, roots beyond the effective degree are left at 0.
 	constexpr std::array<comp_t<Real>, N - 1> roots(std::size_t max_iters = 10000,
-							comp_t<Real> z0 = comp_t<Real>{ 1., 1. }) const {
-		std::array<comp_t<Real>, N - 1> ret;
-		auto d = derivative();
-		auto z = z0;
-		int k = 0;
-		do {
-			for (std::size_t i = 0; i < max_iters; ++i) {
-				auto pz = apply(z);
-				auto dpz = d.apply(z);
-				if (dpz.is_zero() || !dpz.is_normal() || !pz.is_normal() || (pz / dpz).is_zero())
-					break;
-				z = z - (pz / dpz);
-			}
-			if (dist_squared(apply(z), comp<Real>{ 0. }) > 1e-32) {
-				switch (k++) {
-				case 0:
-					z = comp<Real>{ Real{ z.re }, 0. };
-					break;
-				case 1:
-					z = comp<Real>{ 0., Real{ z.im } };
-					break;
-				case 2:
-					z = z * comp<Real>{ 0.5, 0. };
-					break;
-				case 3:
-					z = z * comp<Real>{ 0., 0.5 };
-					break;
-				case 4:
-					z = z * z;
-					break;
-				default:
-					//throw std::runtime_error("Could not converge");
-					(void)0;
-				}
-				max_iters *= 2;
-			}
-		} while (k < 6 && dist_squared(apply(z), comp<Real>{ 0. }) > 1e-32);
-
-		ret[0] = z;
-
-		if (effective_degree() > 1) {
-			auto subp = *this / Polynome<Real, 2>{ { z, 1 } };
-			auto subr = subp.roots(max_iters, z0);
-			for (std::size_t i = 0; i < ret.size() - 1; ++i) {
-				ret[i + 1] = subr[i];
-			}
+							comp_t<Real> z0 = comp_t<Real>{}) const {
+		std::array<comp_t<Real>, N - 1> ret{};
+		auto d = effective_degree();
+		auto zeros = 0;
+		while (zeros < d && coeffs_[zeros].is_zero())
+			++zeros;
+		auto const* c = coeffs_.data() + zeros;
+		auto* z = ret.data() + zeros;
+		d -= zeros;
+		if (d == 1) {
+			z[0] = -c[0] / c[1];
+		} else if (d > 1) {
+			spreadStartingPoints(z, d, z0, meanRootRadius(c, d));
+			aberthRefine(c, d, z, max_iters, Real{ 4 } * std::numeric_limits<Real>::epsilon());
 		}
 		return ret;
 	}
@@ -147,23 +254,21 @@ constexpr Polynome<Real, L - 1 + M - 1 + 1> operator*(Polynome<Real, L> const& l
 	return Polynome<Real, L - 1 + M - 1 + 1>(std::move(ret));
 }
 
-template <typename Real, int M, int Q, int R>
-constexpr Polynome<Real, R> impl_div(Polynome<Real, M> const& rhs, Polynome<Real, Q> const& quot,
-				     Polynome<Real, R> const& rem) {
-	if (rem.effective_degree() <= rhs.effective_degree())
-		return rem;
-
-	auto a = rem.coeffs()[R - 1] / rhs.coeffs()[M - 1];
-	std::array<comp_t<Real>, R - M + 1> t_arr;
-	t_arr[rem.effective_degree() - rhs.effective_degree()] = a;
-	auto polyt = Polynome<Real, R - M + 1>{ std::move(t_arr) };
-	return impl_div(rhs, quot + polyt, rem - (polyt * rhs));
-}
-
+// Euclidean division, the remainder is dropped
 template <typename Real, int L, int M>
 constexpr Polynome<Real, L> operator/(Polynome<Real, L> const& lhs, Polynome<Real, M> const& rhs) {
 	static_assert(M <= L, "Divisor polynomial can't be larger than dividend");
-	return impl_div(rhs, Polynome<Real, 1>{ { 0.0 } }, lhs);
+	std::array<comp_t<Real>, L> quot;
+	auto rem = lhs.coeffs();
+	auto dr = rhs.effective_degree();
+	auto const& lead = rhs.coeffs()[dr];
+	for (int k = lhs.effective_degree(); k >= dr; --k) {
+		auto a = rem[k] / lead;
+		quot[k - dr] = a;
+		for (int j = 0; j <= dr; ++j)
+			rem[k - dr + j] -= a * rhs.coeffs()[j];
+	}
+	return Polynome<Real, L>{ std::move(quot) };
 }
 
 template <typename Real>
@@ -186,3 +291,103 @@ constexpr Polynome<Real, static_cast<int>(1 + N)> polynomFromRoots(std::array<co
 		return polynomFromRoots(roots[0]) * polynomFromRoots(suba);
 	}
 }
+
+// Polynomial of a degree only known at runtime, coeffs points to degree + 1 coefficients, lowest degree first.
+// It does not own them so it can be copied to a kernel.
+template <typename Real>
+struct PolyView {
+	comp_t<Real> const* coeffs;
+	int degree;
+
+	constexpr comp_t<Real> apply(comp_t<Real> const& z) const {
+		auto ret = coeffs[degree];
+		for (int i = degree - 1; i >= 0; --i)
+			ret = ret * z + coeffs[i];
+		return ret;
+	}
+
+	constexpr PolyEval<Real> apply_with_derivative(comp_t<Real> const& z) const {
+		PolyEval<Real> ret{ coeffs[degree], comp_t<Real>{} };
+		for (int i = degree - 1; i >= 0; --i) {
+			ret.dp = ret.dp * z + ret.p;
+			ret.p = ret.p * z + coeffs[i];
+		}
+		return ret;
+	}
+
+	constexpr PolyEval2<Real> apply_with_derivatives(comp_t<Real> const& z) const {
+		PolyEval2<Real> ret{ coeffs[degree], comp_t<Real>{}, comp_t<Real>{} };
+		for (int i = degree - 1; i >= 0; --i) {
+			ret.half_d2p = ret.half_d2p * z + ret.dp;
+			ret.dp = ret.dp * z + ret.p;
+			ret.p = ret.p * z + coeffs[i];
+		}
+		return ret;
+	}
+};
+
+// Coefficients of the monic polynomial having these roots, lowest degree first
+template <typename Real>
+std::vector<comp_t<Real>> coeffsFromRoots(std::vector<comp_t<Real>> const& roots) {
+	std::vector<comp_t<Real>> ret{ comp_t<Real>{ 1. } };
+	for (auto const& r : roots) {
+		// ret *= (z - r)
+		ret.push_back(ret.back());
+		for (auto i = ret.size() - 2; i > 0; --i)
+			ret[i] = ret[i - 1] - r * ret[i];
+		ret[0] = -r * ret[0];
+	}
+	return ret;
+}
+
+// Every root of a polynomial of runtime degree at once (see aberthRefine), trailing zero coefficients are ignored
+// and zero roots are factored out exactly. Steps below tolerance relative to their root stop the iterations.
+template <typename Real>
+std::vector<comp_t<Real>> polyRoots(std::vector<comp_t<Real>> coeffs, std::size_t max_iters = 1000,
+				    Real tolerance = Real{ 1e-14 }) {
+	while (!coeffs.empty() && coeffs.back().is_zero())
+		coeffs.pop_back();
+	if (coeffs.size() < 2)
+		throw std::invalid_argument("Constant polynomials have no roots");
+	auto lead = coeffs.back();
+	for (auto& c : coeffs)
+		c /= lead;
+
+	std::vector<comp_t<Real>> z(coeffs.size() - 1);
+	auto zeros = std::find_if(coeffs.begin(), coeffs.end(), [](auto const& c) { return !c.is_zero(); }) -
+		     coeffs.begin();
+	auto degree = static_cast<int>(coeffs.size() - 1 - zeros);
+	auto* r = z.data() + zeros;
+	if (degree == 1) {
+		r[0] = -coeffs[zeros];
+	} else if (degree > 1) {
+		auto const* c = coeffs.data() + zeros;
+		spreadStartingPoints(r, degree, comp_t<Real>{}, meanRootRadius(c, degree));
+		aberthRefine(c, degree, r, max_iters, tolerance);
+	}
+	return z;
+}
+
+// Roots of many polynomials (see polyRoots), for instance a family swept by a parameter. They are split between
+// the cores of the host, results are in the order of polys.
+template <typename Real>
+std::vector<std::vector<comp_t<Real>>> polyRootsBatch(std::vector<std::vector<comp_t<Real>>> const& polys,
+						      std::size_t max_iters = 1000, Real tolerance = Real{ 1e-14 }) {
+	std::vector<std::vector<comp_t<Real>>> ret(polys.size());
+	auto threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+	auto chunk = (polys.size() + threads - 1) / threads;
+	std::vector<std::future<void>> parts;
+	for (std::size_t b = 0; b < polys.size(); b += chunk) {
+		auto n = std::min(chunk, polys.size() - b);
+		parts.push_back(std::async(std::launch::async, [&, b, n] {
+			for (auto i = b; i < b + n; ++i)
+				ret[i] = polyRoots(polys[i], max_iters, tolerance);
+		}));
+	}
+	// every part is waited for before the first error is thrown, they write into ret
+	for (auto& p : parts)
+		p.wait();
+	for (auto& p : parts)
+		p.get();
+	return ret;
+}
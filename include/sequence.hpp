@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "comp.hpp"
+#include "image.hpp"
+
+// View of a zoom animation reached at a given time (in seconds)
+struct Keyframe {
+	double time;
+	comp<double> center;
+	double inc;
+	std::size_t cycles;
+	std::vector<comp<double>> roots; // empty keeps the polynomial given on the command line
+};
+
+// One keyframe per line: "time re,im inc cycles [re,im ...]", blank lines and lines starting with '#' are
+// skipped. Times must increase; a keyframe without roots keeps those of the previous one.
+std::vector<Keyframe> parseKeyframes(std::istream& is);
+
+// View at time t, clamped to the first and last keyframes. inc is interpolated geometrically so the zoom speed
+// is constant, everything else linearly; roots morph between keyframes of the same degree and jump otherwise.
+Keyframe interpolate(std::vector<Keyframe> const& keys, double t);
+
+// Frames from the first to the last keyframe, both included
+std::size_t frameCount(std::vector<Keyframe> const& keys, unsigned fps);
+
+// Replaces the last run of '#' in pattern by frame, zero padded to the length of the run
+std::string frameName(std::string const& pattern, std::size_t frame);
+
+// Pixel grid of a frame in the complex plane, pixel (x, y) is at topLeft + inc * (x, y)
+struct FrameView {
+	comp<double> topLeft;
+	double inc;
+	std::size_t width, height;
+};
+
+// view can be taken from the nearest pixels of ref: ref is at least as fine and covers it
+bool canResample(FrameView const& ref, FrameView const& view);
+void resample(FrameView const& ref, Rgba const* refPixels, FrameView const& view, Rgba* out);
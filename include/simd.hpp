@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "newton.hpp"
+#include "subdivide.hpp"
+
+// Instruction sets of the host SIMD engine, each one is compiled in its own translation unit
+enum class SimdIsa { Generic, Avx2, Avx512 };
+
+char const* simdIsaName(SimdIsa isa);
+// Compiled in and supported by the CPU running the program
+bool simdIsaAvailable(SimdIsa isa);
+// Widest available instruction set
+SimdIsa bestSimdIsa();
+
+// A view as seen by the SIMD engine: coefficients (lowest degree first) and roots are split into real and
+// imaginary planes so a single load fills a register with the same component of several pixels
+template <typename T>
+struct SimdView {
+	std::vector<T> coeffsRe, coeffsIm;
+	std::vector<T> rootsRe, rootsIm;
+	SampleCoord<T> left, top; // top left pixel, samples are placed like the ones of PixelSampler
+	SampleCoord<T> inc;
+	int cycles;
+	T tolerance;
+	Method method = Method::Newton;
+	T relaxationRe = 1, relaxationIm = 0; // Method::Relaxed only
+};
+
+// The method of the view on n pixels, as many at once as the instruction set allows. Gives the same root indices,
+// iteration counts and shade levels as RuntimePixelSampler.
+template <typename T>
+void simdSample(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		std::uint8_t* shades, SimdIsa isa = bestSimdIsa());
+
+extern template void simdSample(SimdView<float> const&, Pixel const*, std::size_t, std::uint8_t*, int*,
+				std::uint8_t*, SimdIsa);
+extern template void simdSample(SimdView<double> const&, Pixel const*, std::size_t, std::uint8_t*, int*,
+				std::uint8_t*, SimdIsa);
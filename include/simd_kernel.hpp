@@ -0,0 +1,149 @@
+#pragma once
+
+// Only included by src/simd_*.cpp, each of them compiles this kernel for its own instruction set
+
+#include <algorithm>
+#include <array>
+#include <experimental/simd>
+
+#include "newton.hpp"
+#include "simd.hpp"
+
+namespace stdx = std::experimental;
+
+// internal linkage, so the kernels compiled with different instruction sets never get mixed up by the linker
+namespace
+{
+template <Method M, typename T>
+void simdSampleMethod(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		      std::uint8_t* shades) {
+	using V = stdx::native_simd<T>;
+	static constexpr auto W = V::size();
+	static constexpr bool CUBIC = M == Method::Halley || M == Method::Householder;
+	auto const degree = static_cast<int>(view.rootsRe.size());
+	auto const tol2 = V(view.tolerance * view.tolerance);
+	auto const cycles = V(static_cast<T>(view.cycles));
+
+	for (std::size_t base = 0; base < n; base += W) {
+		auto lanes = std::min<std::size_t>(W, n - base);
+		std::array<T, W> xs{}, ys{};
+		for (std::size_t l = 0; l < lanes; ++l) {
+			xs[l] = static_cast<T>(view.left + pixels[base + l].x * view.inc);
+			ys[l] = static_cast<T>(view.top + pixels[base + l].y * view.inc);
+		}
+		V zr = V(xs.data(), stdx::element_aligned);
+		V zi = V(ys.data(), stdx::element_aligned);
+		V it = cycles;
+		auto active = V([&](auto l) { return static_cast<T>(l); }) < V(static_cast<T>(lanes));
+
+		for (int c = 0; c < view.cycles && stdx::any_of(active); ++c) {
+			// Horner pass for p, p' and p'' / 2 if the method needs it, same operations as PolyView
+			V pr = V(view.coeffsRe[degree]), pi = V(view.coeffsIm[degree]);
+			V dr = V(T{}), di = V(T{});
+			V hr = V(T{}), hi = V(T{});
+			for (int k = degree - 1; k >= 0; --k) {
+				if constexpr (CUBIC) {
+					auto nhr = hr * zr - hi * zi + dr;
+					auto nhi = hr * zi + hi * zr + di;
+					hr = nhr;
+					hi = nhi;
+				}
+				auto ndr = dr * zr - di * zi + pr;
+				auto ndi = dr * zi + di * zr + pi;
+				dr = ndr;
+				di = ndi;
+				auto npr = pr * zr - pi * zi + V(view.coeffsRe[k]);
+				auto npi = pr * zi + pi * zr + V(view.coeffsIm[k]);
+				pr = npr;
+				pi = npi;
+			}
+
+			// lanes leave as soon as they converge, like methodConverge
+			auto converged = active && !(pr * pr + pi * pi > tol2);
+			stdx::where(converged, it) = V(static_cast<T>(c));
+			active = active && !converged;
+			auto denom = dr * dr + di * di;
+			auto stalled = active && !(denom > V(T{}));
+			active = active && !stalled;
+
+			// u = p / p', the Newton step
+			auto sr = (pr * dr + pi * di) / denom;
+			auto si = (pi * dr - pr * di) / denom;
+			if constexpr (M == Method::Relaxed) {
+				auto ar = V(view.relaxationRe), ai = V(view.relaxationIm);
+				auto nsr = ar * sr - ai * si;
+				auto nsi = ar * si + ai * sr;
+				sr = nsr;
+				si = nsi;
+			} else if constexpr (CUBIC) {
+				// u t with t = p'' / 2p'
+				auto tr = (hr * dr + hi * di) / denom;
+				auto ti = (hi * dr - hr * di) / denom;
+				auto mr = sr * tr - si * ti;
+				auto mi = sr * ti + si * tr;
+				if constexpr (M == Method::Halley) {
+					// u / (1 - u t)
+					auto wr = V(T{ 1 }) - mr;
+					auto wi = V(T{}) - mi;
+					auto wd = wr * wr + wi * wi;
+					active = active && wd > V(T{});
+					auto nsr = (sr * wr + si * wi) / wd;
+					auto nsi = (si * wr - sr * wi) / wd;
+					sr = nsr;
+					si = nsi;
+				} else {
+					// u + u (u t)
+					auto nsr = sr + (sr * mr - si * mi);
+					auto nsi = si + (sr * mi + si * mr);
+					sr = nsr;
+					si = nsi;
+				}
+			}
+			stdx::where(active, zr) -= sr;
+			stdx::where(active, zi) -= si;
+			auto small = active && !(sr * sr + si * si > tol2);
+			stdx::where(small, it) = V(static_cast<T>(c + 1));
+			active = active && !small;
+		}
+
+		// closest root, first one on ties like closestRootIndex
+		V best = (zr - V(view.rootsRe[0])) * (zr - V(view.rootsRe[0])) +
+			 (zi - V(view.rootsIm[0])) * (zi - V(view.rootsIm[0]));
+		V idx = V(T{});
+		for (int r = 1; r < degree; ++r) {
+			auto l = zr - V(view.rootsRe[r]);
+			auto m = zi - V(view.rootsIm[r]);
+			auto d = l * l + m * m;
+			auto closer = d < best;
+			stdx::where(closer, best) = d;
+			stdx::where(closer, idx) = V(static_cast<T>(r));
+		}
+
+		for (std::size_t l = 0; l < lanes; ++l) {
+			roots[base + l] = static_cast<std::uint8_t>(idx[l]);
+			iters[base + l] = static_cast<int>(it[l]);
+			shades[base + l] = shadeLevel(iters[base + l], view.cycles, T{ best[l] }, view.tolerance,
+						      convergenceOrder(M));
+		}
+	}
+}
+
+// Each method has its own loop, the choice is made once per call
+template <typename T>
+void simdSampleNative(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		      std::uint8_t* shades) {
+	switch (view.method) {
+	case Method::Halley:
+		simdSampleMethod<Method::Halley>(view, pixels, n, roots, iters, shades);
+		break;
+	case Method::Householder:
+		simdSampleMethod<Method::Householder>(view, pixels, n, roots, iters, shades);
+		break;
+	case Method::Relaxed:
+		simdSampleMethod<Method::Relaxed>(view, pixels, n, roots, iters, shades);
+		break;
+	default:
+		simdSampleMethod<Method::Newton>(view, pixels, n, roots, iters, shades);
+	}
+}
+} // namespace
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+// Where the time of a frame went, durations are in seconds
+struct FrameStats {
+	std::size_t frame = 0;
+	bool complete = false;
+	double wall = 0.;	// from the start of the frame to its last result being available on the host
+	double kernel = 0.;	// device execution time of every kernel, from event profiling
+	double kernelSpan = 0.; // first kernel start to last kernel end on the device
+	double transfer = 0.;	// placing the kernel results, already in host memory, into the frame
+	double host = 0.;	// host side scheduling work, e.g. subdivision passes
+	double colorize = 0.;	// host side coloring, only needed when a frame was not colored by the kernels
+	double upload = 0.;	// texture upload, filled by the interface
+	std::size_t kernels = 0;
+	std::size_t pixels = 0;	    // pixels actually computed
+	std::size_t iterations = 0; // Newton steps done by those pixels
+	double flops = 0.;	    // estimated over kernelSpan
+};
+
+// Seconds elapsed since start
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Appends frame statistics to a file, as CSV or as one JSON object per line (.json or .jsonl)
+class FrameStatsLog {
+	std::ofstream ofs;
+	bool json;
+	bool headerWritten;
+
+    public:
+	explicit FrameStatsLog(std::string const& path)
+		: ofs{ path }, json{ path.ends_with(".json") || path.ends_with(".jsonl") }, headerWritten{ false } {
+		if (!ofs)
+			throw std::runtime_error("Could not open " + path);
+	}
+
+	void write(FrameStats const& s) {
+		if (json) {
+			ofs << "{\"frame\":" << s.frame << ",\"wall\":" << s.wall << ",\"kernel\":" << s.kernel
+			    << ",\"kernel_span\":" << s.kernelSpan << ",\"transfer\":" << s.transfer
+			    << ",\"host\":" << s.host << ",\"colorize\":" << s.colorize << ",\"upload\":" << s.upload
+			    << ",\"kernels\":" << s.kernels << ",\"pixels\":" << s.pixels
+			    << ",\"iterations\":" << s.iterations << ",\"flops\":" << s.flops << "}\n";
+		} else {
+			if (!headerWritten) {
+				ofs << "frame,wall,kernel,kernel_span,transfer,host,colorize,upload,kernels,pixels,"
+				       "iterations,flops\n";
+				headerWritten = true;
+			}
+			ofs << s.frame << ',' << s.wall << ',' << s.kernel << ',' << s.kernelSpan << ','
+			    << s.transfer << ',' << s.host << ',' << s.colorize << ',' << s.upload << ','
+			    << s.kernels << ',' << s.pixels << ',' << s.iterations << ',' << s.flops << '\n';
+		}
+		ofs.flush();
+	}
+};
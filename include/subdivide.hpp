@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Pixel coordinates in a frame
+struct Pixel {
+	std::uint32_t x, y;
+};
+
+// Mariani-Silver subdivision: the border of a rectangle is computed first, if every border pixel
+// converges to the same root with a similar iteration count (and shade level, when shades are kept) its interior
+// is filled without being computed, otherwise the rectangle is split in four. Small rectangles are computed entirely.
+// Runs as passes so each batch of pixels can be computed by a single kernel.
+class Subdivider {
+	// inclusive corners
+	struct Rect {
+		std::size_t x0, y0, x1, y1;
+	};
+
+	std::size_t width;
+	std::size_t minSize;
+	int iterSpread;
+	int shadeSpread;
+	std::vector<Rect> rects;
+	std::vector<std::uint8_t> known;
+	std::vector<Pixel> pending;
+	std::size_t computed;
+
+	void request(std::size_t x, std::size_t y) {
+		auto& k = known[y * width + x];
+		if (!k) {
+			k = 1;
+			pending.push_back({ static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y) });
+		}
+	}
+
+	void requestBorders() {
+		for (auto const& r : rects) {
+			for (auto x = r.x0; x <= r.x1; ++x) {
+				request(x, r.y0);
+				request(x, r.y1);
+			}
+			for (auto y = r.y0 + 1; y < r.y1; ++y) {
+				request(r.x0, y);
+				request(r.x1, y);
+			}
+		}
+	}
+
+	// Range of the iteration counts and shades of the border
+	struct Spread {
+		int minIters, maxIters;
+		int minShade, maxShade;
+	};
+
+	// Shades are only checked when frameShades is given
+	template <typename Root>
+	bool uniformBorder(Rect const& r, std::vector<Root> const& frameRoots, std::vector<int> const& frameIters,
+			   std::vector<std::uint8_t> const* frameShades, Spread& s) const {
+		auto corner = r.y0 * width + r.x0;
+		auto root = frameRoots[corner];
+		s.minIters = s.maxIters = frameIters[corner];
+		s.minShade = s.maxShade = frameShades ? (*frameShades)[corner] : 0;
+		auto check = [&](std::size_t x, std::size_t y) {
+			auto i = y * width + x;
+			s.minIters = std::min(s.minIters, frameIters[i]);
+			s.maxIters = std::max(s.maxIters, frameIters[i]);
+			if (frameShades) {
+				s.minShade = std::min<int>(s.minShade, (*frameShades)[i]);
+				s.maxShade = std::max<int>(s.maxShade, (*frameShades)[i]);
+			}
+			return frameRoots[i] == root && s.maxIters - s.minIters <= iterSpread &&
+			       s.maxShade - s.minShade <= shadeSpread;
+		};
+		for (auto x = r.x0; x <= r.x1; ++x) {
+			if (!check(x, r.y0) || !check(x, r.y1))
+				return false;
+		}
+		for (auto y = r.y0 + 1; y < r.y1; ++y) {
+			if (!check(r.x0, y) || !check(r.x1, y))
+				return false;
+		}
+		return true;
+	}
+
+	// Shades are only kept when frameShades is given
+	template <typename Root>
+	void store(Root const* roots, int const* iters, std::uint8_t const* shades, std::vector<Root>& frameRoots,
+		   std::vector<int>& frameIters, std::vector<std::uint8_t>* frameShades) {
+		for (std::size_t i = 0; i < pending.size(); ++i) {
+			auto idx = pending[i].y * width + pending[i].x;
+			frameRoots[idx] = roots[i];
+			frameIters[idx] = iters[i];
+			if (frameShades)
+				(*frameShades)[idx] = shades[i];
+		}
+		computed += pending.size();
+		pending.clear();
+
+		std::vector<Rect> next;
+		for (auto const& r : rects) {
+			if (r.x1 - r.x0 < 2 || r.y1 - r.y0 < 2)
+				continue; // no interior
+			if (r.x1 - r.x0 <= minSize || r.y1 - r.y0 <= minSize) {
+				for (auto y = r.y0 + 1; y < r.y1; ++y) {
+					for (auto x = r.x0 + 1; x < r.x1; ++x)
+						request(x, y);
+				}
+				continue;
+			}
+			Spread s;
+			if (uniformBorder(r, frameRoots, frameIters, frameShades, s)) {
+				auto root = frameRoots[r.y0 * width + r.x0];
+				auto iter = (s.minIters + s.maxIters) / 2;
+				auto shade = static_cast<std::uint8_t>((s.minShade + s.maxShade) / 2);
+				for (auto y = r.y0 + 1; y < r.y1; ++y) {
+					for (auto x = r.x0 + 1; x < r.x1; ++x) {
+						auto idx = y * width + x;
+						known[idx] = 1;
+						frameRoots[idx] = root;
+						frameIters[idx] = iter;
+						if (frameShades)
+							(*frameShades)[idx] = shade;
+					}
+				}
+				continue;
+			}
+			auto mx = (r.x0 + r.x1) / 2;
+			auto my = (r.y0 + r.y1) / 2;
+			next.push_back({ r.x0, r.y0, mx, my });
+			next.push_back({ mx, r.y0, r.x1, my });
+			next.push_back({ r.x0, my, mx, r.y1 });
+			next.push_back({ mx, my, r.x1, r.y1 });
+		}
+		rects = std::move(next);
+		requestBorders();
+	}
+
+    public:
+	// A shade spread of 2 keeps filled interiors within a level of their border, a level is a small fraction of a
+	// Newton step (see shadeLevel)
+	Subdivider(std::size_t width_, std::size_t height_, std::size_t minSize_ = 4, int iterSpread_ = 1,
+		   int shadeSpread_ = 2)
+		: width{ width_ }, minSize{ std::max<std::size_t>(minSize_, 2) }, iterSpread{ iterSpread_ },
+		  shadeSpread{ shadeSpread_ }, known(width_ * height_, 0), computed{ 0 } {
+		if (width_ > 0 && height_ > 0)
+			rects.push_back({ 0, 0, width_ - 1, height_ - 1 });
+		requestBorders();
+	}
+
+	// Pixels which have to be computed before the next pass, empty once the frame is complete
+	std::vector<Pixel> const& requests() const { return pending; }
+	bool done() const { return pending.empty(); }
+	// Number of pixels which were actually computed so far
+	std::size_t computedPixels() const { return computed; }
+
+	// Stores the values of the requested pixels in the frame, fills the uniform rectangles and
+	// subdivides the other ones
+	template <typename Root>
+	void provide(Root const* roots, int const* iters, std::vector<Root>& frameRoots, std::vector<int>& frameIters) {
+		store(roots, iters, nullptr, frameRoots, frameIters, nullptr);
+	}
+
+	// Same with the shade level of each pixel, filled interiors take the middle of the shades of their border
+	template <typename Root>
+	void provide(Root const* roots, int const* iters, std::uint8_t const* shades, std::vector<Root>& frameRoots,
+		     std::vector<int>& frameIters, std::vector<std::uint8_t>& frameShades) {
+		store(roots, iters, shades, frameRoots, frameIters, &frameShades);
+	}
+};
+
+// Runs every pass on the host, sample(x, y) returns the root index and iteration count of a pixel (see PixelResult)
+template <typename F>
+std::size_t subdivideFill(std::size_t width, std::size_t height, std::vector<int>& frameRoots,
+			  std::vector<int>& frameIters, F&& sample, std::size_t minSize = 4, int iterSpread = 1) {
+	Subdivider sub{ width, height, minSize, iterSpread };
+	std::vector<int> roots, iters;
+	while (!sub.done()) {
+		roots.clear();
+		iters.clear();
+		for (auto const& p : sub.requests()) {
+			auto res = sample(p.x, p.y);
+			roots.push_back(res.root);
+			iters.push_back(res.iters);
+		}
+		sub.provide(roots.data(), iters.data(), frameRoots, frameIters);
+	}
+	return sub.computedPixels();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "comp.hpp"
+#include "poly.hpp"
+
+// Pixels of a view and the complex plane, without any window: the viewer's mouse handling is tested on its own
+
+constexpr auto compute_top_left(auto center, auto inc, auto w, auto h) {
+	auto left = inc * static_cast<decltype(inc)>(w / 2);
+	auto top = inc * static_cast<decltype(inc)>(h / 2);
+	return center + comp_t<decltype(inc)>(-left, -top);
+}
+
+struct PixelPos {
+	float x, y;
+};
+
+// Pixel (x, y) of a width x height view is at top_left + inc (x, y), its center pixel is (width / 2, height / 2)
+template <typename T>
+struct ViewMapping {
+	comp<T> top_left;
+	T inc;
+
+	ViewMapping(comp<T> const& center, T const& inc_, std::size_t width, std::size_t height)
+		: top_left{ compute_top_left(center, inc_, width, height) }, inc{ inc_ } {}
+
+	// Position of z in the view, in pixels
+	PixelPos toPixel(comp<T> const& z) const {
+		return { static_cast<float>(static_cast<double>((z.re - top_left.re) / inc)),
+			 static_cast<float>(static_cast<double>((z.im - top_left.im) / inc)) };
+	}
+
+	comp<T> toComplex(int x, int y) const {
+		return top_left + comp<T>(inc * static_cast<T>(x), inc * static_cast<T>(y));
+	}
+};
+
+// Mapping of the current view of a FractalComputer
+template <typename Computer>
+auto viewMapping(Computer const& c) {
+	return ViewMapping{ c.getCenter(), c.getIncrement(), c.getWidth(), c.getHeight() };
+}
+
+// Root closest to (x, y), if within radius pixels of it
+template <typename T>
+std::optional<std::size_t> rootAt(ViewMapping<T> const& view, std::vector<comp<T>> const& roots, int x, int y,
+				  float radius) {
+	std::optional<std::size_t> ret;
+	auto best = radius * radius;
+	for (std::size_t i = 0; i < roots.size(); ++i) {
+		auto p = view.toPixel(roots[i]);
+		auto dx = p.x - static_cast<float>(x);
+		auto dy = p.y - static_cast<float>(y);
+		if (dx * dx + dy * dy <= best) {
+			best = dx * dx + dy * dy;
+			ret = i;
+		}
+	}
+	return ret;
+}
+
+// Roots are edited by dragging them with the mouse. The computer previews frames until the button is released, and
+// its polynomial only changes once per display frame however many mouse moves happened meanwhile.
+template <typename T>
+class RootDrag {
+	std::optional<std::size_t> dragged;
+	std::vector<comp<T>> edited;
+	bool moved = false; // since the last apply
+
+    public:
+	static constexpr float GRAB_RADIUS = 16.f; // in pixels around a root
+
+	// Starts dragging the root under (x, y), if any
+	template <typename Computer>
+	void press(Computer& c, int x, int y) {
+		dragged = rootAt(viewMapping(c), c.getRoots(), x, y, GRAB_RADIUS);
+		if (!dragged)
+			return;
+		edited = c.getRoots();
+		c.updatePreview(true);
+	}
+
+	template <typename Computer>
+	void move(Computer const& c, int x, int y) {
+		if (!dragged)
+			return;
+		edited[*dragged] = viewMapping(c).toComplex(x, y);
+		moved = true;
+	}
+
+	// Called once per display frame
+	template <typename Computer>
+	void apply(Computer& c) {
+		if (!moved)
+			return;
+		c.updatePolyFromRoots(edited);
+		moved = false;
+	}
+
+	// The last position is computed at full quality
+	template <typename Computer>
+	void release(Computer& c) {
+		if (!dragged)
+			return;
+		apply(c);
+		c.updatePreview(false);
+		dragged.reset();
+	}
+
+	bool dragging() const { return dragged.has_value(); }
+
+	// Markers follow the roots being dragged rather than the ones of the frame being displayed
+	template <typename Computer>
+	std::vector<comp<T>> const& roots(Computer const& c) const {
+		return dragged ? edited : c.getRoots();
+	}
+};
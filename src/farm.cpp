@@ -0,0 +1,293 @@
+#include "farm.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+std::vector<Band> splitRows(std::size_t height, std::size_t bandHeight) {
+	if (bandHeight == 0)
+		throw std::invalid_argument("Bands must have at least one row");
+	std::vector<Band> ret;
+	for (std::size_t y = 0; y < height; y += bandHeight) {
+		ret.push_back({ static_cast<std::uint32_t>(ret.size()), static_cast<std::uint32_t>(y),
+				static_cast<std::uint32_t>(std::min(bandHeight, height - y)) });
+	}
+	return ret;
+}
+
+namespace
+{
+void writeAll(int fd, void const* data, std::size_t n) {
+	auto const* p = static_cast<char const*>(data);
+	while (n > 0) {
+		auto w = ::write(fd, p, n);
+		if (w < 0 && errno == EINTR)
+			continue;
+		if (w <= 0)
+			throw std::runtime_error(std::string("Could not write to pipe: ") + std::strerror(errno));
+		p += w;
+		n -= static_cast<std::size_t>(w);
+	}
+}
+
+// Number of bytes read, less than n only at the end of the stream
+std::size_t readAll(int fd, void* data, std::size_t n) {
+	auto* p = static_cast<char*>(data);
+	std::size_t done = 0;
+	while (done < n) {
+		auto r = ::read(fd, p + done, n - done);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r < 0)
+			throw std::runtime_error(std::string("Could not read from pipe: ") + std::strerror(errno));
+		if (r == 0)
+			break;
+		done += static_cast<std::size_t>(r);
+	}
+	return done;
+}
+} // namespace
+
+void sendBand(int fd, Band const& b) { writeAll(fd, &b, sizeof(b)); }
+
+bool receiveBand(int fd, Band& b) {
+	auto n = readAll(fd, &b, sizeof(b));
+	if (n == 0)
+		return false;
+	if (n != sizeof(b))
+		throw std::runtime_error("Truncated band header");
+	return true;
+}
+
+void sendPixels(int fd, Rgba const* pixels, std::size_t n) { writeAll(fd, pixels, n * sizeof(Rgba)); }
+
+void receivePixels(int fd, Rgba* pixels, std::size_t n) {
+	if (readAll(fd, pixels, n * sizeof(Rgba)) != n * sizeof(Rgba))
+		throw std::runtime_error("Truncated band pixels");
+}
+
+void serveBands(int in, int out, std::size_t width, std::function<void(Band const&, Rgba*)> const& render) {
+	Band b;
+	std::vector<Rgba> pixels;
+	while (receiveBand(in, b) && b.h > 0) {
+		pixels.resize(width * b.h);
+		render(b, pixels.data());
+		sendBand(out, b);
+		sendPixels(out, pixels.data(), pixels.size());
+	}
+}
+
+namespace
+{
+// A band being received from a worker, read as it arrives so a stalled worker never blocks the coordinator
+struct Reception {
+	Band header;
+	std::vector<Rgba> pixels;
+	std::size_t bytes; // received so far, header first
+};
+
+// Reads what is available on fd without blocking, true once the whole band is received. Throws if the worker exited
+// or answered with another band.
+bool receiveAvailable(int fd, Band const& expected, Reception& r) {
+	auto headerBytes = sizeof(Band);
+	auto total = headerBytes + r.pixels.size() * sizeof(Rgba);
+	while (r.bytes < total) {
+		auto* dst = r.bytes < headerBytes ? reinterpret_cast<char*>(&r.header) + r.bytes
+						  : reinterpret_cast<char*>(r.pixels.data()) + (r.bytes - headerBytes);
+		auto got = ::read(fd, dst, (r.bytes < headerBytes ? headerBytes : total) - r.bytes);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return false;
+		if (got < 0)
+			throw std::runtime_error(std::string("Could not read from pipe: ") + std::strerror(errno));
+		if (got == 0)
+			throw std::runtime_error(r.bytes == 0 ? "worker exited" : "Truncated band");
+		r.bytes += static_cast<std::size_t>(got);
+		if (r.bytes == headerBytes && (r.header.id != expected.id || r.header.h != expected.h))
+			throw std::runtime_error("unexpected band");
+	}
+	return true;
+}
+
+// A worker process and the pipes to its standard input and output, its results are read without blocking
+class Worker {
+	pid_t pid;
+	int in, out;
+
+    public:
+	std::optional<std::size_t> band; // index of the band being rendered
+	Reception reception;
+	std::chrono::steady_clock::time_point deadline; // of its band
+
+	explicit Worker(std::vector<std::string> const& command) : pid{ -1 }, in{ -1 }, out{ -1 } {
+		int toWorker[2], fromWorker[2];
+		if (pipe2(toWorker, O_CLOEXEC) != 0)
+			throw std::runtime_error("Could not create pipe");
+		if (pipe2(fromWorker, O_CLOEXEC) != 0) {
+			close(toWorker[0]);
+			close(toWorker[1]);
+			throw std::runtime_error("Could not create pipe");
+		}
+		std::vector<char*> argv;
+		for (auto const& a : command)
+			argv.push_back(const_cast<char*>(a.c_str()));
+		argv.push_back(nullptr);
+
+		pid = fork();
+		if (pid == 0) {
+			// dup2 clears close-on-exec, the other ends of the pipes are closed by exec
+			if (dup2(toWorker[0], 0) < 0 || dup2(fromWorker[1], 1) < 0)
+				_exit(127);
+			execvp(argv[0], argv.data());
+			_exit(127);
+		}
+		close(toWorker[0]);
+		close(fromWorker[1]);
+		in = toWorker[1];
+		out = fromWorker[0];
+		if (pid < 0 || fcntl(out, F_SETFL, O_NONBLOCK) != 0) {
+			if (pid > 0)
+				kill();
+			close(in);
+			close(out);
+			if (pid > 0)
+				waitpid(pid, nullptr, 0);
+			throw std::runtime_error("Could not start worker");
+		}
+	}
+
+	Worker(Worker const&) = delete;
+	Worker& operator=(Worker const&) = delete;
+
+	// Asks an idle worker to exit, a busy one is killed
+	~Worker() {
+		try {
+			if (band)
+				kill();
+			else
+				sendBand(in, Band{ 0, 0, 0 });
+		} catch (std::exception const&) {
+			kill();
+		}
+		close(in);
+		close(out);
+		waitpid(pid, nullptr, 0);
+	}
+
+	void kill() { ::kill(pid, SIGKILL); }
+	int requests() const { return in; }
+	int results() const { return out; }
+};
+} // namespace
+
+void runFarm(FarmOptions const& opts, std::size_t width, std::vector<Band> const& bands,
+	     std::function<void(Rgba const*, std::size_t)> const& sink) {
+	if (opts.workers == 0)
+		throw std::invalid_argument("The farm needs at least one worker");
+	// a dead worker is noticed from the result of write, not from a signal
+	std::signal(SIGPIPE, SIG_IGN);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	for (std::size_t i = 0; i < opts.workers; ++i)
+		workers.push_back(std::make_unique<Worker>(opts.workerCommand));
+
+	std::set<std::size_t> todo; // lowest index first, so finished rows can be written early
+	for (std::size_t i = 0; i < bands.size(); ++i)
+		todo.insert(i);
+	std::vector<std::size_t> attempts(bands.size(), 0);
+	std::map<std::size_t, std::vector<Rgba>> finished;
+	std::size_t next = 0; // first band not given to sink yet
+	auto window = 2 * opts.workers;
+
+	auto replace = [&](std::unique_ptr<Worker>& w, std::string const& why) {
+		auto b = *w->band;
+		std::cerr << "Worker failed on band " << b << " (" << why << "), restarting it\n";
+		if (attempts[b] >= opts.maxAttempts)
+			throw std::runtime_error("Band " + std::to_string(b) + " failed " +
+						 std::to_string(attempts[b]) + " times");
+		todo.insert(b);
+		w->kill();
+		w = std::make_unique<Worker>(opts.workerCommand);
+	};
+
+	while (next < bands.size()) {
+		for (auto& w : workers) {
+			if (w->band || todo.empty() || *todo.begin() >= next + window)
+				continue;
+			auto b = *todo.begin();
+			todo.erase(todo.begin());
+			w->band = b;
+			w->reception = { {}, std::vector<Rgba>(width * bands[b].h), 0 };
+			w->deadline = std::chrono::steady_clock::now() + opts.bandTimeout;
+			++attempts[b];
+			try {
+				sendBand(w->requests(), bands[b]);
+			} catch (std::exception const& e) {
+				replace(w, e.what());
+			}
+		}
+
+		std::vector<pollfd> fds;
+		std::vector<std::size_t> polled;
+		auto deadline = std::chrono::steady_clock::time_point::max();
+		for (std::size_t i = 0; i < workers.size(); ++i) {
+			if (workers[i]->band) {
+				fds.push_back({ workers[i]->results(), POLLIN, 0 });
+				polled.push_back(i);
+				deadline = std::min(deadline, workers[i]->deadline);
+			}
+		}
+		if (fds.empty())
+			throw std::runtime_error("No band can be given to a worker");
+		// rounded up, so the earliest deadline is over when poll times out
+		auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+		auto timeout =
+			static_cast<int>(std::clamp<std::int64_t>(left.count(), 0, std::numeric_limits<int>::max()));
+		if (poll(fds.data(), fds.size(), timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			throw std::runtime_error(std::string("Could not wait for workers: ") + std::strerror(errno));
+		}
+
+		for (std::size_t k = 0; k < fds.size(); ++k) {
+			if (fds[k].revents == 0)
+				continue;
+			auto& w = workers[polled[k]];
+			auto b = *w->band;
+			try {
+				if (receiveAvailable(w->results(), bands[b], w->reception)) {
+					finished.emplace(b, std::move(w->reception.pixels));
+					w->band.reset();
+				}
+			} catch (std::exception const& e) {
+				replace(w, e.what());
+			}
+		}
+		auto now = std::chrono::steady_clock::now();
+		for (auto& w : workers) {
+			if (w->band && now >= w->deadline)
+				replace(w, "no result after " + std::to_string(opts.bandTimeout.count()) + "ms");
+		}
+
+		for (auto it = finished.find(next); it != finished.end(); it = finished.find(next)) {
+			sink(it->second.data(), bands[next].h);
+			finished.erase(it);
+			++next;
+		}
+	}
+}
@@ -0,0 +1,236 @@
+#include "image.hpp"
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+std::vector<Rgba> defaultPalette(std::size_t n) {
+	std::vector<Rgba> ret{ { 255, 0, 0, 255 }, { 0, 255, 0, 255 }, { 0, 0, 255, 255 } };
+	if (n <= ret.size()) {
+		ret.resize(n);
+		return ret;
+	}
+	ret.clear();
+	for (std::size_t i = 0; i < n; ++i) {
+		// hue to rgb, full saturation and value
+		auto h = 6. * static_cast<double>(i) / static_cast<double>(n);
+		auto x = 1. - std::abs(std::fmod(h, 2.) - 1.);
+		std::array<double, 3> c{};
+		switch (static_cast<int>(h)) {
+		case 0:
+			c = { 1., x, 0. };
+			break;
+		case 1:
+			c = { x, 1., 0. };
+			break;
+		case 2:
+			c = { 0., 1., x };
+			break;
+		case 3:
+			c = { 0., x, 1. };
+			break;
+		case 4:
+			c = { x, 0., 1. };
+			break;
+		default:
+			c = { 1., 0., x };
+		}
+		ret.push_back({ static_cast<std::uint8_t>(255 * c[0]), static_cast<std::uint8_t>(255 * c[1]),
+				static_cast<std::uint8_t>(255 * c[2]), 255 });
+	}
+	return ret;
+}
+
+std::vector<Rgba> shadeTable(std::vector<Rgba> const& palette, std::size_t levels, double decay) {
+	std::vector<Rgba> ret;
+	ret.reserve(palette.size() * levels);
+	for (auto const& c : palette) {
+		for (std::size_t l = 0; l < levels; ++l) {
+			auto k = decay > 0. ? 0.15 + 0.85 * std::exp(-static_cast<double>(l) / decay) : 1.;
+			auto scale = [k](std::uint8_t v) { return static_cast<std::uint8_t>(std::lround(k * v)); };
+			ret.push_back({ scale(c.r), scale(c.g), scale(c.b), c.a });
+		}
+	}
+	return ret;
+}
+
+void writePpm(std::ostream& os, std::size_t width, std::size_t height, Rgba const* pixels) {
+	writePpmHeader(os, width, height);
+	writePpmRows(os, width, height, pixels);
+}
+
+void writePpmHeader(std::ostream& os, std::size_t width, std::size_t height) {
+	os << "P6\n" << width << " " << height << "\n255\n";
+}
+
+void writePpmRows(std::ostream& os, std::size_t width, std::size_t rows, Rgba const* pixels) {
+	std::vector<char> row(width * 3);
+	for (std::size_t y = 0; y < rows; ++y) {
+		for (std::size_t x = 0; x < width; ++x) {
+			auto const& p = pixels[y * width + x];
+			row[3 * x + 0] = static_cast<char>(p.r);
+			row[3 * x + 1] = static_cast<char>(p.g);
+			row[3 * x + 2] = static_cast<char>(p.b);
+		}
+		os.write(row.data(), static_cast<std::streamsize>(row.size()));
+	}
+}
+
+namespace
+{
+void putBE32(unsigned char* dst, std::uint32_t v) {
+	dst[0] = static_cast<unsigned char>(v >> 24);
+	dst[1] = static_cast<unsigned char>(v >> 16);
+	dst[2] = static_cast<unsigned char>(v >> 8);
+	dst[3] = static_cast<unsigned char>(v);
+}
+} // namespace
+
+PngWriter::PngWriter(std::ostream& os_, std::size_t width_, std::size_t height_)
+	: os{ os_ }, width{ width_ }, height{ height_ }, rows{ 0 }, zs{}, row(1 + 3 * width_), out(1 << 16),
+	  finished{ false } {
+	if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+		throw std::runtime_error("Could not initialize zlib");
+
+	static constexpr unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	os.write(reinterpret_cast<char const*>(signature), sizeof(signature));
+
+	std::array<unsigned char, 13> ihdr{};
+	putBE32(ihdr.data(), static_cast<std::uint32_t>(width));
+	putBE32(ihdr.data() + 4, static_cast<std::uint32_t>(height));
+	ihdr[8] = 8; // bit depth
+	ihdr[9] = 2; // truecolor
+	writeChunk("IHDR", ihdr.data(), ihdr.size());
+}
+
+PngWriter::~PngWriter() {
+	if (!finished && rows == height) {
+		try {
+			finish();
+		} catch (...) {
+		}
+	}
+	deflateEnd(&zs);
+}
+
+void PngWriter::writeChunk(char const* type, unsigned char const* data, std::size_t size) {
+	std::array<unsigned char, 8> head{};
+	putBE32(head.data(), static_cast<std::uint32_t>(size));
+	std::copy(type, type + 4, head.begin() + 4);
+	auto crc = crc32(0, head.data() + 4, 4);
+	if (size > 0) // crc32 resets on a null buffer
+		crc = crc32(crc, data, static_cast<uInt>(size));
+	std::array<unsigned char, 4> tail{};
+	putBE32(tail.data(), static_cast<std::uint32_t>(crc));
+	os.write(reinterpret_cast<char const*>(head.data()), head.size());
+	os.write(reinterpret_cast<char const*>(data), static_cast<std::streamsize>(size));
+	os.write(reinterpret_cast<char const*>(tail.data()), tail.size());
+}
+
+// Feeds zs.next_in to zlib, an IDAT chunk is emitted every time the output buffer is full
+void PngWriter::deflateRow(int flush) {
+	int ret;
+	do {
+		zs.next_out = out.data();
+		zs.avail_out = static_cast<uInt>(out.size());
+		ret = deflate(&zs, flush);
+		if (ret == Z_STREAM_ERROR)
+			throw std::runtime_error("Could not compress PNG data");
+		auto have = out.size() - zs.avail_out;
+		if (have > 0)
+			writeChunk("IDAT", out.data(), have);
+	} while (zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+}
+
+void PngWriter::writeRow(Rgba const* pixels) {
+	if (rows >= height)
+		throw std::runtime_error("Too many rows given to PNG writer");
+	row[0] = 0; // no filter
+	for (std::size_t x = 0; x < width; ++x) {
+		row[1 + 3 * x + 0] = pixels[x].r;
+		row[1 + 3 * x + 1] = pixels[x].g;
+		row[1 + 3 * x + 2] = pixels[x].b;
+	}
+	zs.next_in = row.data();
+	zs.avail_in = static_cast<uInt>(row.size());
+	deflateRow(Z_NO_FLUSH);
+	++rows;
+}
+
+void PngWriter::writeRows(Rgba const* pixels, std::size_t n) {
+	for (std::size_t y = 0; y < n; ++y)
+		writeRow(pixels + y * width);
+}
+
+void PngWriter::finish() {
+	if (finished)
+		return;
+	if (rows != height)
+		throw std::runtime_error("Missing rows in PNG image");
+	zs.next_in = nullptr;
+	zs.avail_in = 0;
+	deflateRow(Z_FINISH);
+	writeChunk("IEND", nullptr, 0);
+	os.flush();
+	finished = true;
+}
+
+ImageWriter::ImageWriter(std::string const& path_, std::size_t width_, std::size_t height_)
+	: path{ path_ }, ofs{ path_, std::ios::binary }, width{ width_ }, height{ height_ }, rows{ 0 } {
+	if (!ofs)
+		throw std::runtime_error("Could not open " + path);
+	if (path.ends_with(".ppm"))
+		writePpmHeader(ofs, width, height);
+	else
+		png.emplace(ofs, width, height);
+}
+
+void ImageWriter::writeRows(Rgba const* pixels, std::size_t n) {
+	if (rows + n > height)
+		throw std::runtime_error("Too many rows given to image writer");
+	if (png)
+		png->writeRows(pixels, n);
+	else
+		writePpmRows(ofs, width, n, pixels);
+	rows += n;
+	if (!ofs)
+		throw std::runtime_error("Could not write " + path);
+}
+
+void ImageWriter::finish() {
+	if (rows != height)
+		throw std::runtime_error("Missing rows in " + path);
+	if (png)
+		png->finish();
+	ofs.flush();
+	if (!ofs)
+		throw std::runtime_error("Could not write " + path);
+}
+
+Y4mWriter::Y4mWriter(std::ostream& os_, std::size_t width_, std::size_t height_, unsigned fps)
+	: os{ os_ }, width{ width_ }, height{ height_ }, planes(3 * width_ * height_) {
+	if (fps == 0)
+		throw std::invalid_argument("Video needs at least one frame per second");
+	os << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C444\n";
+}
+
+void Y4mWriter::writeFrame(Rgba const* pixels) {
+	auto n = width * height;
+	for (std::size_t i = 0; i < n; ++i) {
+		int r = pixels[i].r, g = pixels[i].g, b = pixels[i].b;
+		planes[i] = static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		planes[n + i] = static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+		planes[2 * n + i] = static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+	}
+	os << "FRAME\n";
+	os.write(reinterpret_cast<char const*>(planes.data()), static_cast<std::streamsize>(planes.size()));
+	if (!os)
+		throw std::runtime_error("Could not write video frame");
+}
+
+void writeImage(std::string const& path, std::size_t width, std::size_t height, Rgba const* pixels) {
+	ImageWriter img{ path, width, height };
+	img.writeRows(pixels, height);
+	img.finish();
+}
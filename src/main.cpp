@@ -1,28 +1,33 @@
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 #include "comp.hpp"
 #include "poly.hpp"
 #include "interface.hpp"
 #include "compute.hpp"
 
-using real_t = double;
+// double-double views can be zoomed in far beyond the precision of a double, the kernels only use it when needed
+using real_t = ddouble;
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
-	static constexpr std::array<comp<real_t>, 3> roots{ comp<real_t>{ 1. },
-							    comp<real_t>{ -0.5, -0.866025403784439 },
-							    comp<real_t>(-0.500000000000000, 0.866025403784439) };
+int main(int argc, char* argv[]) {
+	std::vector<comp<real_t>> const roots{ comp<real_t>{ 1. }, comp<real_t>{ -0.5, -0.866025403784439 },
+					       comp<real_t>(-0.500000000000000, 0.866025403784439) };
 	static constexpr auto center = comp_t<real_t>(-0.4, 0.);
 	static constexpr real_t inc = 0.001f;
 	static constexpr std::size_t width = 1920;
 	static constexpr std::size_t height = 1080;
 	static constexpr int cycles = 25;
 
-	auto computer = std::make_shared<FractalComputer<real_t, 4>>( roots, center, inc, width, height, cycles );
+	auto computer = std::make_shared<FractalComputer<real_t>>( roots, center, inc, width, height, cycles );
 	auto interface = Interface{ computer, 10 };
+	// --stats FILE dumps the timings of every frame, as CSV or as JSON lines for a .json(l) file
+	if (argc == 3 && std::string_view{ argv[1] } == "--stats")
+		interface.logFrameStats(argv[2]);
 
 	std::cout << "Initialized with:\n";
 	std::cout << "Poly: ";
-	for (auto const& p : computer->getPoly().coeffs())
+	for (auto const& p : computer->getPoly())
 		std::cout << p << " ";
 	std::cout << "\nRoots: ";
 	for (auto const& r : computer->getRoots())
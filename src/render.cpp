@@ -0,0 +1,471 @@
+#include <array>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "comp.hpp"
+#include "poly.hpp"
+#include "compute.hpp"
+#include "image.hpp"
+#include "farm.hpp"
+#include "sequence.hpp"
+
+using real_t = double;
+
+struct Options {
+	std::vector<comp<real_t>> roots;
+	std::vector<comp<real_t>> coeffs;
+	comp<real_t> center{ -0.4, 0. };
+	real_t inc = 0.001;
+	std::size_t width = 1920;
+	std::size_t height = 1080;
+	std::size_t cycles = 25;
+	real_t tolerance = 1e-6;
+	bool subdivision = false;
+	Precision precision = Precision::Auto;
+	Engine engine = Engine::Sycl;
+	Shading shading = Shading::Smooth;
+	Method method = Method::Newton;
+	comp<real_t> relaxation{ 1. };
+	std::size_t antialias = 1;
+	std::size_t workers = 0; // render farm of local processes, 0 renders in this process
+	std::size_t bandHeight = 256;
+	unsigned bandTimeout = 600; // seconds
+	bool stream = false;
+	bool worker = false;
+	bool help = false;
+	std::string output;
+	std::string stats;
+	std::string index;
+	std::string keyframes;
+	unsigned fps = 30;
+	std::size_t resample = 1;
+};
+
+static void usage(std::ostream& os, char const* name) {
+	os << "Usage: " << name << " [options] -o OUTPUT\n"
+	   << "Renders a Newton fractal to a PNG or PPM image (chosen from the extension of OUTPUT).\n\n"
+	   << "  --root RE,IM        add a root of the polynomial (repeat for each root)\n"
+	   << "  --coeff RE,IM       add a coefficient, lowest degree first (instead of --root)\n"
+	   << "  --center RE,IM      center of the view (default -0.4,0)\n"
+	   << "  --inc INC           distance between two pixels (default 0.001)\n"
+	   << "  --size WxH          resolution (default 1920x1080)\n"
+	   << "  --cycles N          maximum number of Newton iterations (default 25)\n"
+	   << "  --tolerance T       convergence tolerance (default 1e-6)\n"
+	   << "  --subdivision       fill uniform rectangles without computing them\n"
+	   << "  --precision P       auto, float, double or double-double (default auto)\n"
+	   << "  --engine E          sycl, or simd to compute on the host cores (default sycl)\n"
+	   << "  --shading S         flat, or smooth to darken pixels with their iteration count (default smooth)\n"
+	   << "  --method M          iteration method: newton, halley, householder or relaxed (default newton)\n"
+	   << "  --relaxation RE,IM  factor of the steps of relaxed Newton (default 1)\n"
+	   << "  --antialias N       supersample pixels on basin boundaries with up to N samples (default 1, off)\n"
+	   << "  --workers N         render band by band with N local worker processes, for images larger than\n"
+	   << "                      the memory; failed bands are given to a new worker\n"
+	   << "  --stream            render band by band in this process, memory does not depend on the height\n"
+	   << "  --band-height H     rows of a band of --workers or --stream (default 256)\n"
+	   << "  --band-timeout S    seconds a worker may spend on a band before it is replaced (default 600)\n"
+	   << "  --worker            (internal) render the bands read on stdin, results go to stdout\n"
+	   << "  --keyframes PATH    render the zoom animation described by the keyframes in PATH, one per line:\n"
+	   << "                      \"time re,im inc cycles [root re,im ...]\", OUTPUT is then a y4m video (.y4m,\n"
+	   << "                      or - for stdout) or images numbered in place of the last run of #\n"
+	   << "                      (frame####.png)\n"
+	   << "  --fps N             frames per second of the animation (default 30)\n"
+	   << "  --resample F        compute frames F times finer and take the next ones from them while they fit,\n"
+	   << "                      1 computes every frame (default 1)\n"
+	   << "  -o, --output PATH   output image\n"
+	   << "  --index PATH        also write the raw root indices, one byte per pixel in row order\n"
+	   << "  --stats PATH        write the timings of each stage, as CSV or JSON (.json)\n"
+	   << "  -h, --help          show this help\n"
+	   << "Without --root nor --coeff, the roots of z^3 - 1 are used.\n";
+}
+
+static comp<real_t> parseComplex(std::string const& s) {
+	auto sep = s.find(',');
+	if (sep == std::string::npos)
+		return comp<real_t>{ std::stod(s) };
+	return comp<real_t>{ std::stod(s.substr(0, sep)), std::stod(s.substr(sep + 1)) };
+}
+
+static Precision parsePrecision(std::string const& s) {
+	for (auto p : { Precision::Float, Precision::Double, Precision::DoubleDouble, Precision::Auto }) {
+		if (s == precisionName(p))
+			return p;
+	}
+	throw std::invalid_argument("Unknown precision " + s);
+}
+
+static Engine parseEngine(std::string const& s) {
+	for (auto e : { Engine::Sycl, Engine::Simd }) {
+		if (s == engineName(e))
+			return e;
+	}
+	throw std::invalid_argument("Unknown engine " + s);
+}
+
+static Shading parseShading(std::string const& s) {
+	for (auto sh : { Shading::Flat, Shading::Smooth }) {
+		if (s == shadingName(sh))
+			return sh;
+	}
+	throw std::invalid_argument("Unknown shading " + s);
+}
+
+static Method parseMethod(std::string const& s) {
+	for (auto m : { Method::Newton, Method::Halley, Method::Householder, Method::Relaxed }) {
+		if (s == methodName(m))
+			return m;
+	}
+	throw std::invalid_argument("Unknown method " + s);
+}
+
+static Options parseOptions(int argc, char* argv[]) {
+	Options opts;
+	for (int i = 1; i < argc; ++i) {
+		std::string_view arg{ argv[i] };
+		auto value = [&]() -> std::string {
+			if (i + 1 >= argc)
+				throw std::invalid_argument(std::string{ arg } + " expects a value");
+			return argv[++i];
+		};
+		if (arg == "-h" || arg == "--help") {
+			opts.help = true;
+			return opts;
+		} else if (arg == "--root") {
+			opts.roots.push_back(parseComplex(value()));
+		} else if (arg == "--coeff") {
+			opts.coeffs.push_back(parseComplex(value()));
+		} else if (arg == "--center") {
+			opts.center = parseComplex(value());
+		} else if (arg == "--inc") {
+			opts.inc = std::stod(value());
+		} else if (arg == "--size") {
+			auto s = value();
+			auto sep = s.find('x');
+			if (sep == std::string::npos)
+				throw std::invalid_argument("--size expects WxH");
+			opts.width = std::stoul(s.substr(0, sep));
+			opts.height = std::stoul(s.substr(sep + 1));
+		} else if (arg == "--cycles") {
+			opts.cycles = std::stoul(value());
+		} else if (arg == "--tolerance") {
+			opts.tolerance = std::stod(value());
+		} else if (arg == "--subdivision") {
+			opts.subdivision = true;
+		} else if (arg == "--precision") {
+			opts.precision = parsePrecision(value());
+		} else if (arg == "--workers") {
+			opts.workers = std::stoul(value());
+		} else if (arg == "--band-height") {
+			opts.bandHeight = std::stoul(value());
+		} else if (arg == "--band-timeout") {
+			opts.bandTimeout = static_cast<unsigned>(std::stoul(value()));
+		} else if (arg == "--stream") {
+			opts.stream = true;
+		} else if (arg == "--worker") {
+			opts.worker = true;
+		} else if (arg == "--engine") {
+			opts.engine = parseEngine(value());
+		} else if (arg == "--shading") {
+			opts.shading = parseShading(value());
+		} else if (arg == "--method") {
+			opts.method = parseMethod(value());
+		} else if (arg == "--relaxation") {
+			opts.relaxation = parseComplex(value());
+		} else if (arg == "--antialias") {
+			opts.antialias = std::stoul(value());
+		} else if (arg == "-o" || arg == "--output") {
+			opts.output = value();
+		} else if (arg == "--stats") {
+			opts.stats = value();
+		} else if (arg == "--index") {
+			opts.index = value();
+		} else if (arg == "--keyframes") {
+			opts.keyframes = value();
+		} else if (arg == "--fps") {
+			opts.fps = static_cast<unsigned>(std::stoul(value()));
+		} else if (arg == "--resample") {
+			opts.resample = std::stoul(value());
+		} else {
+			throw std::invalid_argument("Unknown option " + std::string{ arg });
+		}
+	}
+	if (opts.output.empty())
+		throw std::invalid_argument("No output given");
+	if (!opts.roots.empty() && !opts.coeffs.empty())
+		throw std::invalid_argument("--root and --coeff can't be mixed");
+	if (opts.roots.empty() && opts.coeffs.empty())
+		opts.roots = { comp<real_t>{ 1. }, comp<real_t>{ -0.5, -0.866025403784439 },
+			       comp<real_t>(-0.500000000000000, 0.866025403784439) };
+	if ((opts.workers > 0 || opts.stream) && !opts.stats.empty())
+		throw std::invalid_argument("--stats can't be used with --workers or --stream");
+	if (opts.workers > 0 && opts.stream)
+		throw std::invalid_argument("--workers and --stream can't be mixed");
+	if (opts.workers > 0 && !opts.index.empty())
+		throw std::invalid_argument("--index can't be used with --workers");
+	if (!opts.keyframes.empty() && (opts.workers > 0 || opts.stream || !opts.stats.empty() || !opts.index.empty()))
+		throw std::invalid_argument("--keyframes can't be used with --workers, --stream, --stats or --index");
+	if (opts.fps == 0 || opts.resample == 0)
+		throw std::invalid_argument("--fps and --resample must be at least 1");
+	if (opts.bandHeight == 0 || opts.bandTimeout == 0)
+		throw std::invalid_argument("--band-height and --band-timeout must be at least 1");
+	return opts;
+}
+
+static std::unique_ptr<FractalComputer<real_t>> makeComputer(Options const& opts, comp<real_t> const& center,
+							     std::size_t height) {
+	// the computer needs some roots to start with, they are replaced by those of the coefficients
+	auto roots = opts.roots.empty() ? std::vector<comp<real_t>>{ comp<real_t>{ 1. } } : opts.roots;
+	auto computer = std::make_unique<FractalComputer<real_t>>(roots, center, opts.inc, opts.width, height,
+								  opts.cycles, opts.tolerance);
+	if (!opts.coeffs.empty())
+		computer->updatePoly(opts.coeffs);
+	computer->updateSubdivision(opts.subdivision);
+	computer->updateEngine(opts.engine);
+	computer->updateShading(opts.shading);
+	computer->updateMethod(opts.method);
+	computer->updateRelaxation(opts.relaxation);
+	computer->updateAntialiasing(opts.antialias);
+	// views are never revisited, caching them would only hold memory
+	computer->updateCacheCapacity(0);
+	// bands of a farm all use the precision of the whole image, so there is no seam between them
+	computer->updatePrecision(opts.precision == Precision::Auto
+					  ? autoPrecision(opts.center, opts.inc, opts.width, opts.height)
+					  : opts.precision);
+	return computer;
+}
+
+// Center of the view of a band, so its top left pixel is the one of the whole image at row b.y
+static comp<real_t> bandCenter(Options const& opts, Band const& b) {
+	auto topLeft = compute_top_left(opts.center, opts.inc, opts.width, opts.height);
+	return topLeft + comp<real_t>(opts.inc * static_cast<real_t>(opts.width / 2),
+				      opts.inc * static_cast<real_t>(b.y + b.h / 2));
+}
+
+// Computes band b of the image with a computer sized for one band, created on the first call. With anti-aliasing
+// the computer also covers a row above and below the band, so pixels on a boundary with a neighbouring band are
+// supersampled like in a whole image. Returns the row of the computer's frame where the band starts.
+static std::size_t computeBand(std::unique_ptr<FractalComputer<real_t>>& computer, Options const& opts,
+			       Band const& b) {
+	auto halo = opts.antialias > 1 ? 1u : 0u;
+	auto top = std::min(b.y, halo);
+	auto bottom = std::min<std::size_t>(opts.height - (b.y + b.h), halo);
+	Band rows{ b.id, b.y - top, static_cast<std::uint32_t>(b.h + top + bottom) };
+	if (!computer)
+		computer = makeComputer(opts, bandCenter(opts, rows), rows.h);
+	if (computer->getHeight() != rows.h)
+		computer->updateHeight(rows.h);
+	computer->updateCenter(bandCenter(opts, rows));
+	computer->compute();
+	return top;
+}
+
+// Worker process of a farm: the protocol uses the original stdout, anything else printed goes to stderr
+static void serveWorker(Options const& opts) {
+	auto out = dup(1);
+	if (out < 0 || dup2(2, 1) < 0)
+		throw std::runtime_error("Could not redirect stdout");
+	std::unique_ptr<FractalComputer<real_t>> computer;
+	serveBands(0, out, opts.width, [&](Band const& b, Rgba* pixels) {
+		auto top = computeBand(computer, opts, b);
+		std::copy_n(computer->getColors() + top * opts.width, opts.width * b.h, pixels);
+	});
+	close(out);
+}
+
+// Raw root indices, in the same row order as the image
+static std::ofstream openIndex(std::string const& path) {
+	std::ofstream ofs(path, std::ios::binary);
+	if (!ofs)
+		throw std::runtime_error("Could not open " + path);
+	return ofs;
+}
+
+static void writeIndex(std::ofstream& ofs, std::uint8_t const* indices, std::size_t n) {
+	if (!ofs.write(reinterpret_cast<char const*>(indices), static_cast<std::streamsize>(n)))
+		throw std::runtime_error("Could not write the root indices");
+}
+
+// Single process version of the farm: one band at a time is computed and written, so the buffers of the
+// device and of the host hold band height rows whatever the height of the image
+static void renderStream(Options const& opts) {
+	ImageWriter image{ opts.output, opts.width, opts.height };
+	std::optional<std::ofstream> index;
+	if (!opts.index.empty())
+		index = openIndex(opts.index);
+	std::unique_ptr<FractalComputer<real_t>> computer;
+	auto start = std::chrono::steady_clock::now();
+	auto bands = splitRows(opts.height, opts.bandHeight);
+	for (auto const& b : bands) {
+		auto offset = computeBand(computer, opts, b) * opts.width;
+		if (index)
+			writeIndex(*index, computer->getResult().data() + offset, opts.width * b.h);
+		image.writeRows(computer->getColors() + offset, b.h);
+	}
+	image.finish();
+	if (index && !index->flush())
+		throw std::runtime_error("Could not write the root indices");
+	std::cout << "Computed in " << secondsSince(start) << "s in " << bands.size() << " bands\n";
+}
+
+// Bands are written to the image as soon as the ones above them are done, the image is never fully in memory
+static void renderFarm(Options const& opts, std::vector<std::string> const& args) {
+	FarmOptions farm{ args, opts.workers, 3, std::chrono::seconds{ opts.bandTimeout } };
+	farm.workerCommand.push_back("--worker");
+	ImageWriter image{ opts.output, opts.width, opts.height };
+	auto start = std::chrono::steady_clock::now();
+	runFarm(farm, opts.width, splitRows(opts.height, opts.bandHeight),
+		[&](Rgba const* rows, std::size_t n) { image.writeRows(rows, n); });
+	image.finish();
+	std::cout << "Computed in " << secondsSince(start) << "s by " << opts.workers << " workers\n";
+}
+
+// Zoom animation along the keyframes. Each frame is encoded while the next one is computed; with --resample F > 1
+// the computer renders references F times finer than the frame and the following frames are taken from their
+// nearest pixels, as long as the reference covers them with pixels at least as fine as theirs.
+static void renderSequence(Options const& opts) {
+	std::ifstream keyfile(opts.keyframes);
+	if (!keyfile)
+		throw std::runtime_error("Could not open " + opts.keyframes);
+	auto keys = parseKeyframes(keyfile);
+	auto frames = frameCount(keys, opts.fps);
+
+	// stdout may be the video, everything else goes to stderr
+	auto refOpts = opts;
+	refOpts.width *= opts.resample;
+	refOpts.height *= opts.resample;
+	auto computer = makeComputer(refOpts, keys.front().center, refOpts.height);
+	// the precision follows the zoom instead of being the one of the first view
+	computer->updatePrecision(opts.precision);
+	computer->printDeviceInfos(std::clog);
+
+	std::ofstream file;
+	std::optional<Y4mWriter> video;
+	if (opts.output == "-" || opts.output.ends_with(".y4m")) {
+		if (opts.output != "-") {
+			file.open(opts.output, std::ios::binary);
+			if (!file)
+				throw std::runtime_error("Could not open " + opts.output);
+		}
+		video.emplace(opts.output == "-" ? std::cout : file, opts.width, opts.height, opts.fps);
+	} else {
+		frameName(opts.output, 0); // checks the pattern before computing anything
+	}
+
+	std::array<std::vector<Rgba>, 2> buffers;
+	for (auto& b : buffers)
+		b.resize(opts.width * opts.height);
+	std::optional<FrameView> ref;
+	std::size_t refCycles = 0;
+	std::vector<comp<real_t>> refRoots;
+	std::size_t computed = 0;
+	std::future<void> encoding;
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < frames; ++i) {
+		auto k = interpolate(keys, keys.front().time + static_cast<double>(i) / opts.fps);
+		FrameView view{ compute_top_left(k.center, k.inc, opts.width, opts.height), k.inc, opts.width,
+				opts.height };
+		// without --resample every frame is computed, even one close enough to be taken from the last
+		if (opts.resample == 1 || !ref || k.cycles != refCycles || k.roots != refRoots ||
+		    !canResample(*ref, view)) {
+			auto refInc = k.inc / static_cast<real_t>(opts.resample);
+			computer->updateCenter(k.center);
+			computer->updateInc(refInc);
+			computer->updateCycles(k.cycles);
+			if (!k.roots.empty() && k.roots != refRoots)
+				computer->updatePolyFromRoots(k.roots);
+			computer->compute();
+			ref = FrameView{ compute_top_left(k.center, refInc, refOpts.width, refOpts.height), refInc,
+					 refOpts.width, refOpts.height };
+			refCycles = k.cycles;
+			refRoots = k.roots;
+			++computed;
+		}
+		auto& pixels = buffers[i % 2];
+		resample(*ref, computer->getColors(), view, pixels.data());
+
+		// the buffer of frame i - 1 is free once it is encoded, it will hold frame i + 1
+		if (encoding.valid())
+			encoding.get();
+		encoding = std::async(std::launch::async, [&opts, &video, &pixels, i] {
+			if (video)
+				video->writeFrame(pixels.data());
+			else
+				writeImage(frameName(opts.output, i), opts.width, opts.height, pixels.data());
+		});
+	}
+	if (encoding.valid())
+		encoding.get();
+	if (video) {
+		(opts.output == "-" ? std::cout : file).flush();
+		if (opts.output != "-" && !file)
+			throw std::runtime_error("Could not write " + opts.output);
+	}
+	std::clog << "Rendered " << frames << " frames (" << computed << " computed) in " << secondsSince(start)
+		  << "s\n";
+}
+
+static void render(Options const& opts) {
+	auto computer = makeComputer(opts, opts.center, opts.height);
+	computer->printDeviceInfos(std::cout);
+	if (opts.engine == Engine::Simd)
+		std::cout << "SIMD engine: " << simdIsaName(bestSimdIsa()) << "\n";
+	auto const& indices = computer->compute();
+	std::cout << "Computed in " << computer->getIterTime() << "s\n";
+
+	// pixels are colored by the device
+	writeImage(opts.output, opts.width, opts.height, computer->getColors());
+	if (!opts.index.empty()) {
+		auto index = openIndex(opts.index);
+		writeIndex(index, indices.data(), opts.width * opts.height);
+		if (!index.flush())
+			throw std::runtime_error("Could not write the root indices");
+	}
+
+	if (!opts.stats.empty())
+		FrameStatsLog{ opts.stats }.write(computer->getFrameStats());
+}
+
+int main(int argc, char* argv[]) {
+	Options opts;
+	try {
+		opts = parseOptions(argc, argv);
+	} catch (std::exception const& e) {
+		std::cerr << e.what() << "\n\n";
+		usage(std::cerr, argv[0]);
+		return 1;
+	}
+	if (opts.help) {
+		usage(std::cout, argv[0]);
+		return 0;
+	}
+
+	try {
+		if (opts.worker) {
+			serveWorker(opts);
+			return 0;
+		}
+		if (!opts.keyframes.empty()) {
+			renderSequence(opts);
+			std::clog << "Written " << opts.output << std::endl;
+			return 0;
+		}
+		if (opts.workers > 0)
+			renderFarm(opts, std::vector<std::string>(argv, argv + argc));
+		else if (opts.stream)
+			renderStream(opts);
+		else
+			render(opts);
+	} catch (std::exception const& e) {
+		std::cerr << "Error: " << e.what() << "\n";
+		return 1;
+	}
+	std::cout << "Written " << opts.output << std::endl;
+	return 0;
+}
@@ -0,0 +1,129 @@
+#include "sequence.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+comp<double> parseComplex(std::string const& s) {
+	auto sep = s.find(',');
+	if (sep == std::string::npos)
+		return comp<double>{ std::stod(s) };
+	return comp<double>{ std::stod(s.substr(0, sep)), std::stod(s.substr(sep + 1)) };
+}
+
+comp<double> lerp(comp<double> const& a, comp<double> const& b, double s) {
+	return a + (b - a) * comp<double>{ static_cast<double>(s) };
+}
+
+// Index of the reference pixel closest to p, on one axis
+long nearest(double p, double origin, double inc) { return std::lround((p - origin) / inc); }
+} // namespace
+
+std::vector<Keyframe> parseKeyframes(std::istream& is) {
+	std::vector<Keyframe> ret;
+	std::string line;
+	for (std::size_t n = 1; std::getline(is, line); ++n) {
+		std::istringstream ls{ line };
+		std::string first;
+		if (!(ls >> first) || first.starts_with('#'))
+			continue;
+		try {
+			Keyframe k;
+			std::string center, root;
+			k.time = std::stod(first);
+			if (!(ls >> center >> k.inc >> k.cycles))
+				throw std::invalid_argument("expected time, center, inc and cycles");
+			k.center = parseComplex(center);
+			while (ls >> root)
+				k.roots.push_back(parseComplex(root));
+			if (!(k.inc > 0.))
+				throw std::invalid_argument("inc must be positive");
+			if (!ret.empty() && !(k.time > ret.back().time))
+				throw std::invalid_argument("times must increase");
+			if (k.roots.empty() && !ret.empty())
+				k.roots = ret.back().roots;
+			ret.push_back(std::move(k));
+		} catch (std::exception const& e) {
+			throw std::invalid_argument("Keyframe line " + std::to_string(n) + ": " + e.what());
+		}
+	}
+	if (ret.empty())
+		throw std::invalid_argument("No keyframe given");
+	return ret;
+}
+
+Keyframe interpolate(std::vector<Keyframe> const& keys, double t) {
+	if (t <= keys.front().time)
+		return keys.front();
+	if (t >= keys.back().time)
+		return keys.back();
+	auto next = std::upper_bound(keys.begin(), keys.end(), t,
+				     [](double v, Keyframe const& k) { return v < k.time; });
+	auto const& a = *(next - 1);
+	auto const& b = *next;
+	auto s = (t - a.time) / (b.time - a.time);
+
+	Keyframe ret;
+	ret.time = t;
+	ret.center = lerp(a.center, b.center, s);
+	ret.inc = a.inc * std::pow(b.inc / a.inc, s);
+	auto ca = static_cast<double>(a.cycles), cb = static_cast<double>(b.cycles);
+	ret.cycles = static_cast<std::size_t>(std::lround(ca + (cb - ca) * s));
+	if (a.roots.size() == b.roots.size()) {
+		for (std::size_t i = 0; i < a.roots.size(); ++i)
+			ret.roots.push_back(lerp(a.roots[i], b.roots[i], s));
+	} else {
+		ret.roots = a.roots;
+	}
+	return ret;
+}
+
+std::size_t frameCount(std::vector<Keyframe> const& keys, unsigned fps) {
+	// the epsilon keeps a last keyframe falling exactly on a frame despite rounding
+	auto duration = keys.back().time - keys.front().time;
+	return static_cast<std::size_t>(std::floor(duration * fps + 1e-9)) + 1;
+}
+
+std::string frameName(std::string const& pattern, std::size_t frame) {
+	auto end = pattern.find_last_of('#');
+	if (end == std::string::npos)
+		throw std::invalid_argument("Frame names need a run of # in " + pattern);
+	auto begin = pattern.find_last_not_of('#', end);
+	begin = begin == std::string::npos ? 0 : begin + 1;
+	auto digits = std::to_string(frame);
+	auto width = end + 1 - begin;
+	if (digits.size() < width)
+		digits.insert(0, width - digits.size(), '0');
+	return pattern.substr(0, begin) + digits + pattern.substr(end + 1);
+}
+
+bool canResample(FrameView const& ref, FrameView const& view) {
+	if (ref.inc > view.inc || view.width == 0 || view.height == 0)
+		return false;
+	// the mapping is monotonic, so the corners are enough
+	auto left = nearest(view.topLeft.re, ref.topLeft.re, ref.inc);
+	auto right = nearest(view.topLeft.re + view.inc * static_cast<double>(view.width - 1), ref.topLeft.re, ref.inc);
+	auto top = nearest(view.topLeft.im, ref.topLeft.im, ref.inc);
+	auto bottom =
+		nearest(view.topLeft.im + view.inc * static_cast<double>(view.height - 1), ref.topLeft.im, ref.inc);
+	return left >= 0 && top >= 0 && right < static_cast<long>(ref.width) && bottom < static_cast<long>(ref.height);
+}
+
+void resample(FrameView const& ref, Rgba const* refPixels, FrameView const& view, Rgba* out) {
+	if (!canResample(ref, view))
+		throw std::invalid_argument("Frame is not covered by the reference");
+	std::vector<std::size_t> cols(view.width);
+	for (std::size_t x = 0; x < view.width; ++x)
+		cols[x] = static_cast<std::size_t>(
+			nearest(view.topLeft.re + view.inc * static_cast<double>(x), ref.topLeft.re, ref.inc));
+	for (std::size_t y = 0; y < view.height; ++y) {
+		auto row = static_cast<std::size_t>(
+			nearest(view.topLeft.im + view.inc * static_cast<double>(y), ref.topLeft.im, ref.inc));
+		auto const* src = refPixels + row * ref.width;
+		for (std::size_t x = 0; x < view.width; ++x)
+			out[y * view.width + x] = src[cols[x]];
+	}
+}
@@ -0,0 +1,76 @@
+#include "simd.hpp"
+
+#include <stdexcept>
+#include <string>
+
+// one definition per instruction set, see src/simd_*.cpp
+extern bool const simdAvx2Compiled;
+extern bool const simdAvx512Compiled;
+
+template <typename T>
+void simdSampleGeneric(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		       std::uint8_t* shades);
+template <typename T>
+void simdSampleAvx2(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		    std::uint8_t* shades);
+template <typename T>
+void simdSampleAvx512(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		      std::uint8_t* shades);
+
+char const* simdIsaName(SimdIsa isa) {
+	switch (isa) {
+	case SimdIsa::Generic:
+		return "generic";
+	case SimdIsa::Avx2:
+		return "avx2";
+	case SimdIsa::Avx512:
+		return "avx512";
+	}
+	return "unknown";
+}
+
+bool simdIsaAvailable(SimdIsa isa) {
+	switch (isa) {
+	case SimdIsa::Generic:
+		return true;
+#if defined(__x86_64__) || defined(__i386__)
+	case SimdIsa::Avx2:
+		return simdAvx2Compiled && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	case SimdIsa::Avx512:
+		return simdAvx512Compiled && __builtin_cpu_supports("avx512f");
+#endif
+	default:
+		return false;
+	}
+}
+
+SimdIsa bestSimdIsa() {
+	static SimdIsa const best = simdIsaAvailable(SimdIsa::Avx512) ? SimdIsa::Avx512
+				    : simdIsaAvailable(SimdIsa::Avx2) ? SimdIsa::Avx2
+								       : SimdIsa::Generic;
+	return best;
+}
+
+template <typename T>
+void simdSample(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		std::uint8_t* shades, SimdIsa isa) {
+	if (view.rootsRe.empty() || view.coeffsRe.size() != view.rootsRe.size() + 1)
+		throw std::invalid_argument("SIMD view needs a polynomial of degree at least 1 and all of its roots");
+	if (!simdIsaAvailable(isa))
+		throw std::invalid_argument(std::string("Instruction set not available: ") + simdIsaName(isa));
+	switch (isa) {
+	case SimdIsa::Avx512:
+		simdSampleAvx512(view, pixels, n, roots, iters, shades);
+		break;
+	case SimdIsa::Avx2:
+		simdSampleAvx2(view, pixels, n, roots, iters, shades);
+		break;
+	default:
+		simdSampleGeneric(view, pixels, n, roots, iters, shades);
+	}
+}
+
+template void simdSample(SimdView<float> const&, Pixel const*, std::size_t, std::uint8_t*, int*,
+			 std::uint8_t*, SimdIsa);
+template void simdSample(SimdView<double> const&, Pixel const*, std::size_t, std::uint8_t*, int*,
+			 std::uint8_t*, SimdIsa);
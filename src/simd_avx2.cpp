@@ -0,0 +1,20 @@
+// Built with -mavx2 -mfma when the compiler supports them, see CMakeLists.txt
+#include "simd_kernel.hpp"
+
+#if defined(__AVX2__) && defined(__FMA__)
+extern bool const simdAvx2Compiled = true;
+
+template <typename T>
+void simdSampleAvx2(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		    std::uint8_t* shades) {
+	simdSampleNative(view, pixels, n, roots, iters, shades);
+}
+#else
+extern bool const simdAvx2Compiled = false;
+
+template <typename T>
+void simdSampleAvx2(SimdView<T> const&, Pixel const*, std::size_t, std::uint8_t*, int*, std::uint8_t*) {}
+#endif
+
+template void simdSampleAvx2(SimdView<float> const&, Pixel const*, std::size_t, std::uint8_t*, int*, std::uint8_t*);
+template void simdSampleAvx2(SimdView<double> const&, Pixel const*, std::size_t, std::uint8_t*, int*, std::uint8_t*);
@@ -0,0 +1,11 @@
+// Baseline instruction set of the build, always available
+#include "simd_kernel.hpp"
+
+template <typename T>
+void simdSampleGeneric(SimdView<T> const& view, Pixel const* pixels, std::size_t n, std::uint8_t* roots, int* iters,
+		       std::uint8_t* shades) {
+	simdSampleNative(view, pixels, n, roots, iters, shades);
+}
+
+template void simdSampleGeneric(SimdView<float> const&, Pixel const*, std::size_t, std::uint8_t*, int*, std::uint8_t*);
+template void simdSampleGeneric(SimdView<double> const&, Pixel const*, std::size_t, std::uint8_t*, int*, std::uint8_t*);
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "antialias.hpp"
+
+TEST(Antialias, boundary_pixels) {
+	// two basins split between columns 1 and 2, plus a lone pixel
+	std::vector<std::uint8_t> roots{ 0, 0, 1, 1, //
+					 0, 0, 1, 1, //
+					 0, 0, 1, 0 };
+	auto b = boundaryPixels(roots.data(), 4, 3);
+	std::vector<std::uint32_t> expected{ 1, 2, 5, 6, 9, 10, 11, 7 };
+	std::sort(expected.begin(), expected.end());
+	EXPECT_EQ(b, expected);
+
+	std::vector<std::uint8_t> uniform(12, 2);
+	EXPECT_TRUE(boundaryPixels(uniform.data(), 4, 3).empty());
+}
+
+TEST(Antialias, boundary_pixels_on_shade_jumps) {
+	// a single basin, shades jump by 10 levels between the left columns of rows 0 and 1, by 7 at most elsewhere
+	std::vector<std::uint8_t> roots(12, 0);
+	std::vector<std::uint8_t> shades{ 10, 11, 12, 13, //
+					  20, 21, 14, 15, //
+					  21, 22, 15, 16 };
+	EXPECT_TRUE(boundaryPixels(roots.data(), 4, 3).empty());
+	EXPECT_EQ(boundaryPixels(roots.data(), 4, 3, shades.data(), 8), (std::vector<std::uint32_t>{ 0, 1, 4, 5 }));
+	EXPECT_TRUE(boundaryPixels(roots.data(), 4, 3, shades.data(), 10).empty());
+	// roots still count
+	roots[11] = 1;
+	EXPECT_EQ(boundaryPixels(roots.data(), 4, 3, shades.data(), 10), (std::vector<std::uint32_t>{ 7, 10, 11 }));
+}
+
+TEST(Antialias, sub_samples) {
+	auto s = subSamples({ 0, 5 }, 4, 2);
+	ASSERT_EQ(s.size(), 8u);
+	EXPECT_EQ(s[0].x, 0u);
+	EXPECT_EQ(s[0].y, 0u);
+	EXPECT_EQ(s[3].x, 1u);
+	EXPECT_EQ(s[3].y, 1u);
+	// pixel (1, 1) covers (2, 2) to (3, 3) on the finer grid
+	EXPECT_EQ(s[4].x, 2u);
+	EXPECT_EQ(s[4].y, 2u);
+	EXPECT_EQ(s[5].x, 3u);
+	EXPECT_EQ(s[5].y, 2u);
+	EXPECT_EQ(s[7].x, 3u);
+	EXPECT_EQ(s[7].y, 3u);
+}
+
+TEST(Antialias, blend) {
+	std::vector<Rgba> c{ { 255, 0, 0, 255 }, { 0, 255, 0, 255 }, { 0, 0, 255, 255 }, { 0, 0, 255, 255 } };
+	auto b = blend(c.data(), c.size());
+	EXPECT_EQ(b.r, 64);
+	EXPECT_EQ(b.g, 64);
+	EXPECT_EQ(b.b, 128);
+	EXPECT_EQ(b.a, 255);
+	auto one = blend(c.data(), 1);
+	EXPECT_EQ(one.r, 255);
+	EXPECT_EQ(one.g, 0);
+}
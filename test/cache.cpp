@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cache.hpp"
+
+TEST(Cache, hits_and_misses) {
+	LruCache<std::string, int> cache{ 100 };
+	EXPECT_EQ(cache.find("a"), nullptr);
+	cache.insert("a", 1, 10);
+	cache.insert("b", 2, 10);
+	ASSERT_NE(cache.find("a"), nullptr);
+	EXPECT_EQ(*cache.find("a"), 1);
+	EXPECT_EQ(cache.getHits(), 2u);
+	EXPECT_EQ(cache.getMisses(), 1u);
+	EXPECT_EQ(cache.getUsed(), 20u);
+
+	// replacing a value updates its size
+	cache.insert("b", 3, 30);
+	EXPECT_EQ(*cache.find("b"), 3);
+	EXPECT_EQ(cache.getSize(), 2u);
+	EXPECT_EQ(cache.getUsed(), 40u);
+}
+
+TEST(Cache, evicts_least_recently_used) {
+	LruCache<int, int> cache{ 30 };
+	cache.insert(1, 1, 10);
+	cache.insert(2, 2, 10);
+	cache.insert(3, 3, 10);
+	cache.find(1); // 2 is now the oldest
+	cache.insert(4, 4, 10);
+	EXPECT_EQ(cache.find(2), nullptr);
+	EXPECT_NE(cache.find(1), nullptr);
+	EXPECT_NE(cache.find(3), nullptr);
+	EXPECT_NE(cache.find(4), nullptr);
+
+	// larger than the budget, never kept
+	cache.insert(5, 5, 31);
+	EXPECT_EQ(cache.find(5), nullptr);
+	EXPECT_EQ(cache.getSize(), 3u);
+
+	cache.updateCapacity(10);
+	EXPECT_EQ(cache.getSize(), 1u);
+	EXPECT_NE(cache.find(4), nullptr);
+	cache.updateCapacity(0);
+	EXPECT_EQ(cache.getSize(), 0u);
+	EXPECT_EQ(cache.getUsed(), 0u);
+}
@@ -0,0 +1,383 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+
+// SYCL is the host stub of test/stub: kernels run when the queues are waited for
+#include "compute.hpp"
+
+namespace
+{
+using Computer = FractalComputer<double>;
+
+std::vector<comp<double>> const roots{ comp<double>{ 1. }, comp<double>{ -0.5, -0.866025403784439 },
+				       comp<double>{ -0.5, 0.866025403784439 } };
+
+// Small frames with small tiles, so every refinement level has several tiles
+std::unique_ptr<Computer> makeComputer(comp<double> const& center = { -0.2, 0.1 }, double inc = 0.02,
+				       std::size_t width = 160, std::size_t height = 120,
+				       Precision precision = Precision::Double) {
+	auto ret = std::make_unique<Computer>(roots, center, inc, width, height, 25);
+	ret->updateTileSize(32);
+	ret->updatePrecision(precision);
+	return ret;
+}
+
+// Same view computed from scratch by a new computer
+std::unique_ptr<Computer> freshRender(Computer const& c) {
+	auto ret = makeComputer(c.getCenter(), c.getIncrement(), c.getWidth(), c.getHeight(), c.getPrecision());
+	ret->updateEngine(c.getEngine());
+	ret->compute();
+	return ret;
+}
+
+// Pixels whose root, iteration count, shade or color differ
+std::size_t differingPixels(Computer const& a, Computer const& b) {
+	std::size_t ret = 0;
+	for (std::size_t i = 0; i < a.getWidth() * a.getHeight(); ++i) {
+		if (a.getResult()[i] != b.getResult()[i] || a.getIterations()[i] != b.getIterations()[i] ||
+		    a.getShades()[i] != b.getShades()[i] ||
+		    std::memcmp(a.getColors() + i, b.getColors() + i, sizeof(Rgba)) != 0)
+			++ret;
+	}
+	return ret;
+}
+
+// The oldest kernel submitted is done, the others are still queued
+void runFirstKernel() {
+	auto& commands = cl::sycl::stub::commands;
+	auto c = std::move(commands.front());
+	commands.pop_front();
+	c->kernel();
+	c->done = true;
+}
+} // namespace
+
+// Auto computes this view in float, its samples are placed in double so shifted pixels are exact too
+TEST(Compute, pan_same_as_fresh_render) {
+	for (auto precision : { Precision::Double, Precision::Auto }) {
+		auto c = makeComputer({ -0.2, 0.1 }, 0.02, 160, 120, precision);
+		c->compute();
+		for (auto [dx, dy] :
+		     { std::pair{ 13, 7 }, std::pair{ -40, 0 }, std::pair{ 0, -25 }, std::pair{ -3, 90 } }) {
+			if (dx > 0)
+				c->moveRight(dx);
+			else
+				c->moveLeft(-dx);
+			if (dy > 0)
+				c->moveDown(dy);
+			else
+				c->moveUp(-dy);
+			c->compute();
+			// only the uncovered strips were computed
+			EXPECT_LT(c->getFrameStats().pixels, c->getWidth() * c->getHeight());
+			EXPECT_EQ(differingPixels(*c, *freshRender(*c)), 0u);
+		}
+		EXPECT_EQ(c->getKernelPrecision(), precision == Precision::Auto ? Precision::Float : precision);
+	}
+}
+
+TEST(Compute, pan_switching_precision_computes_full_frame) {
+	// pixels are barely far enough apart for float around the center, panning right makes them too close
+	auto c = makeComputer({ 1.03, 0. }, PRECISION_GUARD * std::numeric_limits<float>::epsilon() * 1.05, 160, 120,
+			      Precision::Auto);
+	c->compute();
+	ASSERT_EQ(c->getKernelPrecision(), Precision::Float);
+	for (int i = 0; i < 20 && c->getKernelPrecision() == Precision::Float; ++i) {
+		c->moveRight(100);
+		c->compute();
+	}
+	ASSERT_EQ(c->getKernelPrecision(), Precision::Double);
+	EXPECT_EQ(c->getFrameStats().pixels, c->getWidth() * c->getHeight());
+	EXPECT_EQ(differingPixels(*c, *freshRender(*c)), 0u);
+}
+
+// Around the origin coordinates are below 1, pixels are inc apart relative to 1
+TEST(Compute, auto_precision_thresholds) {
+	auto floatLimit = PRECISION_GUARD * std::numeric_limits<float>::epsilon();
+	auto doubleLimit = PRECISION_GUARD * std::numeric_limits<double>::epsilon();
+	comp<double> origin{ 0. };
+	EXPECT_EQ(autoPrecision(origin, floatLimit * 1.01, 160, 120), Precision::Float);
+	EXPECT_EQ(autoPrecision(origin, floatLimit * 0.99, 160, 120), Precision::Double);
+	EXPECT_EQ(autoPrecision(origin, doubleLimit * 1.01, 160, 120), Precision::Double);
+	EXPECT_EQ(autoPrecision(origin, doubleLimit * 0.99, 160, 120), Precision::DoubleDouble);
+	// far from the origin coordinates are larger, so are their ulps
+	comp<double> far{ 4., -2. };
+	EXPECT_EQ(autoPrecision(far, floatLimit * 1.01, 160, 120), Precision::Double);
+	EXPECT_EQ(autoPrecision(far, floatLimit * 4.01, 160, 120), Precision::Float);
+	EXPECT_EQ(autoPrecision(far, doubleLimit * 4.01, 160, 120), Precision::Double);
+	EXPECT_EQ(autoPrecision(far, doubleLimit * 3.99, 160, 120), Precision::DoubleDouble);
+}
+
+TEST(Compute, zoom_switches_precision) {
+	auto c = makeComputer({ -0.2, 0.1 }, 0.02, 32, 24, Precision::Auto);
+	// precisions of the frames in order, without repetitions
+	std::vector<Precision> seen;
+	auto render = [&] {
+		c->compute();
+		EXPECT_EQ(c->getKernelPrecision(),
+			  autoPrecision(c->getCenter(), c->getIncrement(), c->getWidth(), c->getHeight()));
+		if (seen.empty() || seen.back() != c->getKernelPrecision())
+			seen.push_back(c->getKernelPrecision());
+	};
+	render();
+	while (c->getKernelPrecision() != Precision::DoubleDouble) {
+		c->zoomIn(20);
+		render();
+	}
+	while (c->getKernelPrecision() != Precision::Float) {
+		c->zoomOut(20);
+		render();
+	}
+	EXPECT_EQ(seen, (std::vector{ Precision::Float, Precision::Double, Precision::DoubleDouble, Precision::Double,
+				      Precision::Float }));
+}
+
+TEST(Compute, cancelled_tiles_ignored) {
+	auto c = makeComputer();
+	// the first tiles of the frame are in flight, then some are collected and others submitted
+	c->poll();
+	EXPECT_FALSE(c->isFrameComplete());
+	cl::sycl::stub::runKernels();
+	c->poll();
+	EXPECT_GT(c->getTilesDone(), 0u);
+	EXPECT_LT(c->getTilesDone(), c->getTilesTotal());
+	c->updateCenter({ 0.3, -0.2 });
+	c->compute();
+	EXPECT_EQ(differingPixels(*c, *freshRender(*c)), 0u);
+}
+
+TEST(Compute, progressive_levels_refine_to_full_render) {
+	auto c = makeComputer();
+	std::vector<std::size_t> strides;
+	while (!c->isFrameComplete()) {
+		c->poll();
+		cl::sycl::stub::runKernels();
+		auto s = c->getDisplayedStride();
+		// a displayed level covers every pixel with its samples
+		if (s > 0 && (strides.empty() || strides.back() != s)) {
+			strides.push_back(s);
+			EXPECT_EQ(std::count(c->getResult().begin(), c->getResult().end(), Computer::NO_ROOT), 0);
+		}
+	}
+	EXPECT_EQ(strides, (std::vector<std::size_t>{ 8, 4, 2, 1 }));
+
+	// samples of the coarse levels are reused by the finer ones
+	auto direct = makeComputer();
+	direct->updateCoarsestStride(1);
+	direct->compute();
+	EXPECT_EQ(direct->getFrameStats().pixels, c->getFrameStats().pixels);
+	EXPECT_EQ(differingPixels(*c, *direct), 0u);
+}
+
+TEST(Compute, subdivision_close_to_full_render) {
+	for (auto [center, inc] :
+	     { std::pair{ comp<double>{ -0.2, 0.1 }, 0.02 }, std::pair{ comp<double>{ 1.3, 0. }, 0.005 } }) {
+		auto c = makeComputer(center, inc);
+		c->updateSubdivision(true);
+		c->compute();
+		auto full = freshRender(*c);
+		// filled interiors take the middle of the shades of their border, which are at most 2 levels apart. A
+		// level darkens a color by less than 4.
+		for (std::size_t i = 0; i < c->getWidth() * c->getHeight(); ++i) {
+			ASSERT_EQ(c->getResult()[i], full->getResult()[i]);
+			ASSERT_LE(std::abs(c->getShades()[i] - full->getShades()[i]), 1);
+			auto a = c->getColors()[i], b = full->getColors()[i];
+			ASSERT_LE(std::max({ std::abs(a.r - b.r), std::abs(a.g - b.g), std::abs(a.b - b.b) }), 4);
+		}
+	}
+	// smooth views are mostly filled
+	auto c = makeComputer({ 1.3, 0. }, 0.005);
+	c->updateSubdivision(true);
+	c->compute();
+	EXPECT_LT(c->getFrameStats().pixels, c->getWidth() * c->getHeight() / 2);
+}
+
+TEST(Compute, devices_share_frame) {
+	cl::sycl::stub::deviceCount = 3;
+	auto c = makeComputer();
+	cl::sycl::stub::deviceCount = 1;
+	ASSERT_EQ(c->getDeviceCount(), 3u);
+	// a single tile in flight per device, bands hold different numbers of tiles so the first device done steals
+	c->updateMaxTilesInFlight(1);
+	for (auto center : { comp<double>{ -0.2, 0.1 }, comp<double>{ 0.4, 0.3 } }) {
+		// the second frame is split after the throughputs measured on the first one
+		c->updateCenter(center);
+		c->compute();
+		auto shares = c->getDeviceShares();
+		ASSERT_EQ(shares.size(), 3u);
+		EXPECT_NEAR(std::accumulate(shares.begin(), shares.end(), 0.), 1., 1e-9);
+		EXPECT_EQ(differingPixels(*c, *freshRender(*c)), 0u);
+	}
+	for (auto t : c->getDeviceThroughputs())
+		EXPECT_GT(t, 0.);
+}
+
+TEST(Compute, antialiased_frame_shrinks) {
+	auto c = makeComputer();
+	c->updateAntialiasing(4);
+	c->compute();
+	ASSERT_GT(c->getSupersampledPixels(), 0u);
+	// supersampled pixels of the larger frame are not in the smaller one
+	c->updateHeight(30);
+	c->compute();
+	auto fresh = makeComputer(c->getCenter(), c->getIncrement(), c->getWidth(), c->getHeight());
+	fresh->updateAntialiasing(4);
+	fresh->compute();
+	EXPECT_EQ(differingPixels(*c, *fresh), 0u);
+}
+
+TEST(Compute, antialiased_pan_reuses_samples) {
+	auto c = makeComputer();
+	c->updateAntialiasing(16);
+	c->compute();
+	c->moveRight(13);
+	c->moveDown(7);
+	c->compute();
+	// uncovered strips, and the samples of the pixels on a boundary close to them only
+	std::size_t strips = 13 * 120 + 7 * (160 - 13);
+	EXPECT_LT(c->getFrameStats().pixels, strips + c->getSupersampledPixels() * 16 / 4);
+	auto fresh = makeComputer(c->getCenter());
+	fresh->updateAntialiasing(16);
+	fresh->compute();
+	EXPECT_EQ(differingPixels(*c, *fresh), 0u);
+
+	// a frame restored from the cache computes nothing at all
+	auto inc = c->getIncrement();
+	c->updateInc(inc / 2);
+	c->compute();
+	c->updateInc(inc);
+	c->compute();
+	EXPECT_EQ(c->getCacheHits(), 1u);
+	EXPECT_EQ(c->getFrameStats().pixels, 0u);
+	EXPECT_EQ(differingPixels(*c, *fresh), 0u);
+}
+
+TEST(Compute, cache_restores_antialiased_frame_on_devices) {
+	cl::sycl::stub::deviceCount = 3;
+	auto c = makeComputer({ -0.2, 0.1 }, 0.02, 160, 60);
+	cl::sycl::stub::deviceCount = 1;
+	c->updateAntialiasing(4);
+	c->compute();
+	// the taller frame computed last has its bands past the end of the restored one
+	c->updateHeight(120);
+	c->compute();
+	c->updateHeight(60);
+	c->compute();
+	EXPECT_EQ(c->getCacheHits(), 1u);
+	EXPECT_GT(c->getSupersampledPixels(), 0u);
+
+	auto fresh = makeComputer(c->getCenter(), c->getIncrement(), c->getWidth(), c->getHeight());
+	fresh->updateAntialiasing(4);
+	fresh->compute();
+	EXPECT_EQ(differingPixels(*c, *fresh), 0u);
+}
+
+TEST(Compute, cache_restores_fresh_render) {
+	std::vector<Rgba> const palette{ { 200, 40, 40, 255 }, { 40, 200, 40, 255 }, { 40, 40, 200, 255 } };
+	auto c = makeComputer();
+	c->compute();
+	auto inc = c->getIncrement();
+	c->updateInc(inc / 2);
+	c->compute();
+	// the palette changes meanwhile, restored frames are colored with the current one
+	c->updatePalette(palette);
+	c->updateInc(inc);
+	c->compute();
+	EXPECT_EQ(c->getCacheHits(), 1u);
+	EXPECT_EQ(c->getFrameStats().pixels, 0u);
+
+	auto fresh = makeComputer(c->getCenter(), inc);
+	fresh->updatePalette(palette);
+	fresh->compute();
+	EXPECT_EQ(differingPixels(*c, *fresh), 0u);
+}
+
+TEST(Compute, preview_samples_match_full_render) {
+	for (auto engine : { Engine::Sycl, Engine::Simd }) {
+		auto c = makeComputer();
+		c->updateEngine(engine);
+		c->updatePreview(true);
+		c->compute();
+		auto full = freshRender(*c);
+		auto s = c->getPreviewStride();
+		// a sample fills its block
+		for (std::size_t y = 0; y < c->getHeight(); ++y) {
+			for (std::size_t x = 0; x < c->getWidth(); ++x) {
+				auto i = y * c->getWidth() + x, sample = (y - y % s) * c->getWidth() + x - x % s;
+				ASSERT_EQ(c->getResult()[i], full->getResult()[sample]);
+				ASSERT_EQ(c->getIterations()[i], full->getIterations()[sample]);
+				ASSERT_EQ(c->getShades()[i], full->getShades()[sample]);
+			}
+		}
+	}
+}
+
+TEST(Compute, moves_during_preview_coalesce) {
+	// several preview tiles in flight, and more pending
+	auto c = makeComputer();
+	c->updatePreviewStride(2);
+	c->updateMaxTilesInFlight(3);
+	c->updatePreview(true);
+	c->poll();
+	auto frame = c->getFrameStats().frame;
+	auto inFlight = cl::sycl::stub::commands.size();
+	ASSERT_GT(inFlight, 1u);
+	// the preview keeps running while the view moves, none of its pending tiles is submitted anymore
+	for (int i = 0; i < 10; ++i) {
+		c->moveRight(3);
+		if (i == 5)
+			runFirstKernel();
+		c->poll();
+		EXPECT_EQ(c->getFrameStats().frame, frame);
+	}
+	EXPECT_EQ(cl::sycl::stub::commands.size(), inFlight - 1);
+	// a single frame for the ten moves
+	c->compute();
+	EXPECT_EQ(c->getFrameStats().frame, frame + 1);
+	auto fresh = makeComputer(c->getCenter());
+	fresh->updatePreviewStride(2);
+	fresh->updatePreview(true);
+	fresh->compute();
+	EXPECT_EQ(differingPixels(*c, *fresh), 0u);
+}
+
+TEST(Compute, preview_pan_same_as_fresh_preview) {
+	auto c = makeComputer();
+	c->updatePreview(true);
+	c->compute();
+	auto fresh = [&] {
+		auto ret = makeComputer(c->getCenter());
+		ret->updatePreview(true);
+		ret->compute();
+		return ret;
+	};
+	// panned by less than a block, once the preview is done and while it is running
+	c->moveRight(3);
+	c->moveUp(5);
+	c->compute();
+	EXPECT_EQ(differingPixels(*c, *fresh()), 0u);
+	c->moveLeft(11);
+	c->poll();
+	c->moveDown(2);
+	c->compute();
+	EXPECT_EQ(differingPixels(*c, *fresh()), 0u);
+}
+
+TEST(Compute, preview_disabled_computes_fresh_render) {
+	for (auto engine : { Engine::Sycl, Engine::Simd }) {
+		auto c = makeComputer();
+		c->updateEngine(engine);
+		c->updatePreview(true);
+		c->compute();
+		for (int i = 0; i < 10; ++i)
+			c->moveDown(2);
+		c->compute();
+		c->updatePreview(false);
+		c->compute();
+		EXPECT_EQ(differingPixels(*c, *freshRender(*c)), 0u);
+	}
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "ddouble.hpp"
+#include "comp.hpp"
+#include "poly.hpp"
+#include "newton.hpp"
+
+namespace
+{
+double absError(ddouble const& a, ddouble const& b) {
+	auto d = a - b;
+	return std::abs(d.hi + d.lo);
+}
+} // namespace
+
+TEST(DDouble, keeps_small_parts) {
+	static constexpr auto tiny = 0x1p-80;
+	static constexpr auto sum = ddouble{ 1. } + ddouble{ tiny };
+	EXPECT_EQ(sum.hi, 1.);
+	EXPECT_EQ(sum.lo, tiny);
+	EXPECT_EQ((sum - ddouble{ 1. }).hi, tiny);
+}
+
+TEST(DDouble, product) {
+	// (1 + 2^-40)^2 = 1 + 2^-39 + 2^-80, the last term is lost by a double
+	auto x = ddouble{ 1. } + ddouble{ 0x1p-40 };
+	auto p = x * x;
+	EXPECT_EQ(p.hi, 1. + 0x1p-39);
+	EXPECT_EQ(p.lo, 0x1p-80);
+}
+
+TEST(DDouble, product_exact_in_constant_expressions) {
+	// a = 1 + 2^-26 + 2^-52 and b = 1 - 2^-27 + 2^-50 use every bit of a double, their product has bits down to
+	// 2^-102 and a double only keeps the first 53 of them
+	static constexpr auto a = 0x1.0000004000001p+0, b = 0x1.ffffffc000008p-1;
+	static constexpr auto c = ddouble{ a } * ddouble{ b };
+	static_assert(c.hi == 0x1.0000002000005p+0);
+	static_assert(c.lo == -0x1.fffffc7fffff0p-54);
+	// and the same at run time, where std::fma is used
+	volatile double va = a, vb = b;
+	auto r = ddouble{ va } * ddouble{ vb };
+	EXPECT_EQ(r.hi, c.hi);
+	EXPECT_EQ(r.lo, c.lo);
+}
+
+TEST(DDouble, division) {
+	auto third = ddouble{ 1. } / ddouble{ 3. };
+	EXPECT_LT(absError(third * ddouble{ 3. }, ddouble{ 1. }), 1e-31);
+	auto q = ddouble{ 2. } / ddouble{ 7. };
+	EXPECT_LT(absError(q * ddouble{ 7. }, ddouble{ 2. }), 1e-31);
+}
+
+TEST(DDouble, comparisons) {
+	auto a = ddouble{ 1. } + ddouble{ 0x1p-70 };
+	EXPECT_LT(ddouble{ 1. }, a);
+	EXPECT_GT(a, ddouble{ 1. });
+	EXPECT_FALSE(a == ddouble{ 1. });
+	EXPECT_EQ(static_cast<double>(a), 1.);
+	EXPECT_LT(-a, ddouble{ -1. });
+}
+
+TEST(DDouble, newton_beyond_double) {
+	// root of x^2 - 2, accurate far below the precision of a double
+	Polynome<ddouble, 3> p{ { comp<ddouble>{ -2. }, comp<ddouble>{}, comp<ddouble>{ 1. } } };
+	auto res = newtonConverge(p, comp<ddouble>{ 1. }, 100, ddouble{ 1e-30 });
+	auto sq = res.z.re * res.z.re;
+	EXPECT_LT(absError(sq, ddouble{ 2. }), 1e-30);
+	EXPECT_EQ(res.z.re.hi, std::sqrt(2.));
+	EXPECT_NE(res.z.re.lo, 0.);
+}
+
+TEST(DDouble, comp_cast) {
+	auto z = comp_cast<ddouble>(comp<double>{ 0.5, -2. });
+	EXPECT_EQ(z.re.hi, 0.5);
+	EXPECT_EQ(z.im.hi, -2.);
+	auto f = comp_cast<float>(comp<ddouble>{ ddouble{ 0.25 }, ddouble{ 1. } });
+	EXPECT_FLOAT_EQ(f.re, 0.25f);
+	EXPECT_FLOAT_EQ(f.im, 1.f);
+}
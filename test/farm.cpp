@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "farm.hpp"
+
+namespace
+{
+static constexpr std::size_t WIDTH = 5;
+
+// Runs the farm with workers started as FARM_TEST_WORKER WIDTH args..., the image is gathered from the sink
+std::vector<Rgba> runTestFarm(std::vector<std::string> const& args, std::size_t workers, std::size_t height,
+			      std::size_t bandHeight) {
+	FarmOptions opts{ { FARM_TEST_WORKER, std::to_string(WIDTH) }, workers, 3, std::chrono::milliseconds{ 500 } };
+	opts.workerCommand.insert(opts.workerCommand.end(), args.begin(), args.end());
+	std::vector<Rgba> ret;
+	runFarm(opts, WIDTH, splitRows(height, bandHeight), [&](Rgba const* rows, std::size_t n) {
+		ret.insert(ret.end(), rows, rows + WIDTH * n);
+	});
+	return ret;
+}
+
+// Rows given to the sink are the top ones of the image, in order: the test workers put x and y in each pixel
+void expectTopRows(std::vector<Rgba> const& image) {
+	for (std::size_t i = 0; i < image.size(); ++i) {
+		auto y = i / WIDTH;
+		EXPECT_EQ(image[i].r, i % WIDTH);
+		EXPECT_EQ(image[i].g | (image[i].b << 8), y);
+	}
+}
+} // namespace
+
+TEST(Farm, split_rows) {
+	auto bands = splitRows(10, 4);
+	ASSERT_EQ(bands.size(), 3u);
+	EXPECT_EQ(bands[0].y, 0u);
+	EXPECT_EQ(bands[1].y, 4u);
+	EXPECT_EQ(bands[2].y, 8u);
+	EXPECT_EQ(bands[2].h, 2u);
+	EXPECT_EQ(bands[2].id, 2u);
+	EXPECT_TRUE(splitRows(0, 4).empty());
+	EXPECT_THROW(splitRows(10, 0), std::invalid_argument);
+}
+
+TEST(Farm, serve_bands) {
+	int requests[2], results[2];
+	ASSERT_EQ(pipe(requests), 0);
+	ASSERT_EQ(pipe(results), 0);
+	static constexpr std::size_t width = 3;
+	// each pixel holds its row in the image
+	std::thread worker{ [&] {
+		serveBands(requests[0], results[1], width, [](Band const& b, Rgba* px) {
+			for (std::size_t i = 0; i < width * b.h; ++i)
+				px[i] = Rgba{ static_cast<std::uint8_t>(b.y + i / width), 0, 0, 255 };
+		});
+		close(results[1]);
+	} };
+
+	for (auto const& b : splitRows(5, 2)) {
+		sendBand(requests[1], b);
+		Band got;
+		ASSERT_TRUE(receiveBand(results[0], got));
+		EXPECT_EQ(got.id, b.id);
+		EXPECT_EQ(got.h, b.h);
+		std::vector<Rgba> px(width * got.h);
+		receivePixels(results[0], px.data(), px.size());
+		for (std::size_t i = 0; i < px.size(); ++i)
+			EXPECT_EQ(px[i].r, b.y + i / width);
+	}
+	sendBand(requests[1], Band{ 0, 0, 0 });
+	worker.join();
+	Band got;
+	EXPECT_FALSE(receiveBand(results[0], got));
+	for (auto fd : { requests[0], requests[1], results[0] })
+		close(fd);
+}
+
+TEST(Farm, run_farm) {
+	auto image = runTestFarm({}, 3, 301, 8);
+	EXPECT_EQ(image.size(), WIDTH * 301);
+	expectTopRows(image);
+}
+
+TEST(Farm, run_farm_restarts_crashed_worker) {
+	auto marker = std::filesystem::temp_directory_path() / ("farm-crash-" + std::to_string(getpid()));
+	std::filesystem::remove(marker);
+	// the worker rendering band 3 exits halfway through it, the band is given to its replacement
+	auto image = runTestFarm({ "crash", "3", marker.string() }, 3, 40, 4);
+	EXPECT_TRUE(std::filesystem::exists(marker));
+	std::filesystem::remove(marker);
+	EXPECT_EQ(image.size(), WIDTH * 40);
+	expectTopRows(image);
+}
+
+TEST(Farm, run_farm_restarts_stalled_worker) {
+	auto marker = std::filesystem::temp_directory_path() / ("farm-hang-" + std::to_string(getpid()));
+	std::filesystem::remove(marker);
+	// the worker rendering band 5 stops halfway through it without exiting, it is killed once the band times out
+	auto start = std::chrono::steady_clock::now();
+	auto image = runTestFarm({ "hang", "5", marker.string() }, 3, 40, 4);
+	EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{ 500 });
+	EXPECT_TRUE(std::filesystem::exists(marker));
+	std::filesystem::remove(marker);
+	EXPECT_EQ(image.size(), WIDTH * 40);
+	expectTopRows(image);
+}
+
+TEST(Farm, run_farm_gives_up_on_failing_band) {
+	// band 2 fails on each of its 3 attempts, only the bands above it may have reached the sink
+	std::vector<Rgba> image;
+	FarmOptions opts{ { FARM_TEST_WORKER, std::to_string(WIDTH), "fail", "2" }, 2, 3, std::chrono::seconds{ 10 } };
+	EXPECT_THROW(runFarm(opts, WIDTH, splitRows(40, 4),
+			     [&](Rgba const* rows, std::size_t n) {
+				     image.insert(image.end(), rows, rows + WIDTH * n);
+			     }),
+		     std::runtime_error);
+	EXPECT_LE(image.size(), WIDTH * 8);
+	expectTopRows(image);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "image.hpp"
+
+namespace
+{
+std::uint32_t readBE32(std::string const& s, std::size_t pos) {
+	auto b = [&](std::size_t i) { return static_cast<std::uint32_t>(static_cast<unsigned char>(s[pos + i])); };
+	return (b(0) << 24) | (b(1) << 16) | (b(2) << 8) | b(3);
+}
+} // namespace
+
+TEST(Image, default_palette) {
+	auto p = defaultPalette(3);
+	ASSERT_EQ(p.size(), 3u);
+	EXPECT_EQ(p[0].r, 255);
+	EXPECT_EQ(p[1].g, 255);
+	EXPECT_EQ(p[2].b, 255);
+	EXPECT_EQ(defaultPalette(7).size(), 7u);
+}
+
+TEST(Image, shade_table) {
+	std::vector<Rgba> palette{ { 200, 100, 0, 255 }, { 0, 0, 255, 128 } };
+	auto flat = shadeTable(palette, 4, 0.);
+	ASSERT_EQ(flat.size(), 8u);
+	EXPECT_EQ(flat[3].r, 200);
+	EXPECT_EQ(flat[7].b, 255);
+
+	auto smooth = shadeTable(palette, 256, 64.);
+	ASSERT_EQ(smooth.size(), 512u);
+	EXPECT_EQ(smooth[0].r, 200);
+	EXPECT_EQ(smooth[0].g, 100);
+	EXPECT_EQ(smooth[256].b, 255);
+	// darker with every level, alpha is kept
+	for (std::size_t l = 1; l < 256; ++l)
+		EXPECT_LE(smooth[256 + l].b, smooth[256 + l - 1].b);
+	EXPECT_EQ(smooth[256 + 64].b, 118); // 0.15 + 0.85 / e
+	EXPECT_EQ(smooth[511].a, 128);
+}
+
+TEST(Image, ppm) {
+	std::vector<Rgba> px{ { 1, 2, 3, 255 }, { 4, 5, 6, 255 } };
+	std::ostringstream os;
+	writePpm(os, 2, 1, px.data());
+	EXPECT_EQ(os.str(), std::string("P6\n2 1\n255\n\x01\x02\x03\x04\x05\x06"));
+}
+
+TEST(Image, png_roundtrip) {
+	static constexpr std::size_t w = 37, h = 23;
+	std::vector<Rgba> px(w * h);
+	for (std::size_t i = 0; i < px.size(); ++i)
+		px[i] = { static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(i / w), 7, 255 };
+
+	std::ostringstream os;
+	{
+		PngWriter png{ os, w, h };
+		for (std::size_t y = 0; y < h; ++y)
+			png.writeRow(px.data() + y * w);
+		png.finish();
+	}
+	auto s = os.str();
+	ASSERT_EQ(s.substr(1, 3), "PNG");
+	EXPECT_EQ(readBE32(s, 16), w);
+	EXPECT_EQ(readBE32(s, 20), h);
+
+	// concatenate every IDAT chunk and check their CRC
+	std::string idat;
+	bool iend = false;
+	for (std::size_t pos = 8; pos < s.size();) {
+		auto len = readBE32(s, pos);
+		auto type = s.substr(pos + 4, 4);
+		auto crc = crc32(0, reinterpret_cast<Bytef const*>(s.data() + pos + 4), len + 4);
+		EXPECT_EQ(crc, readBE32(s, pos + 8 + len));
+		if (type == "IDAT")
+			idat += s.substr(pos + 8, len);
+		iend = type == "IEND";
+		pos += 12 + len;
+	}
+	EXPECT_TRUE(iend);
+
+	std::vector<unsigned char> raw(h * (1 + 3 * w));
+	uLongf rawSize = raw.size();
+	ASSERT_EQ(uncompress(raw.data(), &rawSize, reinterpret_cast<Bytef const*>(idat.data()), idat.size()), Z_OK);
+	ASSERT_EQ(rawSize, raw.size());
+	for (std::size_t y = 0; y < h; ++y) {
+		EXPECT_EQ(raw[y * (1 + 3 * w)], 0);
+		for (std::size_t x = 0; x < w; ++x) {
+			auto const& p = px[y * w + x];
+			auto const* r = &raw[y * (1 + 3 * w) + 1 + 3 * x];
+			EXPECT_EQ(r[0], p.r);
+			EXPECT_EQ(r[1], p.g);
+			EXPECT_EQ(r[2], p.b);
+		}
+	}
+}
+
+TEST(Image, png_missing_rows) {
+	std::ostringstream os;
+	PngWriter png{ os, 4, 4 };
+	std::vector<Rgba> row(4);
+	png.writeRow(row.data());
+	EXPECT_THROW(png.finish(), std::runtime_error);
+}
+
+TEST(Image, writer_streams_ppm_rows) {
+	static constexpr std::size_t w = 3, h = 4;
+	std::vector<Rgba> px(w * h);
+	for (std::size_t i = 0; i < px.size(); ++i)
+		px[i] = Rgba{ static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(2 * i), 7, 255 };
+	auto path = (std::filesystem::temp_directory_path() / "newton_writer_test.ppm").string();
+	{
+		ImageWriter img{ path, w, h };
+		img.writeRows(px.data(), 1);
+		img.writeRows(px.data() + w, h - 1);
+		EXPECT_THROW(img.writeRows(px.data(), 1), std::runtime_error);
+		img.finish();
+	}
+	std::ifstream ifs(path, std::ios::binary);
+	std::string written{ std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+	std::ostringstream expected;
+	writePpm(expected, w, h, px.data());
+	EXPECT_EQ(written, expected.str());
+	std::filesystem::remove(path);
+}
+
+TEST(Image, y4m_frames) {
+	std::vector<Rgba> px{ { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 255, 0, 0, 255 }, { 0, 0, 255, 255 } };
+	std::ostringstream os;
+	Y4mWriter video{ os, 2, 2, 25 };
+	video.writeFrame(px.data());
+	video.writeFrame(px.data());
+	std::string header = "YUV4MPEG2 W2 H2 F25:1 Ip A1:1 C444\n";
+	auto s = os.str();
+	ASSERT_EQ(s.size(), header.size() + 2 * (6 + 12));
+	EXPECT_EQ(s.substr(0, header.size()), header);
+	EXPECT_EQ(s.substr(header.size(), 6), "FRAME\n");
+	auto const* y = reinterpret_cast<unsigned char const*>(s.data() + header.size() + 6);
+	// studio range: black and white luma, neutral chroma for grays
+	EXPECT_EQ(y[0], 16);
+	EXPECT_EQ(y[1], 235);
+	EXPECT_EQ(y[4], 128);
+	EXPECT_EQ(y[5], 128);
+	// red has a high Cr, blue a high Cb
+	EXPECT_GT(y[8 + 2], 200);
+	EXPECT_GT(y[4 + 3], 200);
+	EXPECT_THROW((Y4mWriter{ os, 2, 2, 0 }), std::invalid_argument);
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "ddouble.hpp"
+#include "newton.hpp"
+
+TEST(Newton, converge_early_exit) {
+	static constexpr Polynome<double, 3> p{ { -1., 0., 1. } }; // x2 - 1
+	auto res = newtonConverge(p, comp<double>{ 2., 0.5 }, 1000, 1e-9);
+	EXPECT_NEAR(res.z.re, 1., 1e-6);
+	EXPECT_NEAR(res.z.im, 0., 1e-6);
+	EXPECT_GT(res.iters, 0);
+	EXPECT_LT(res.iters, 1000);
+}
+
+TEST(Newton, converge_already_on_root) {
+	static constexpr Polynome<double, 3> p{ { -1., 0., 1. } }; // x2 - 1
+	static constexpr auto res = newtonConverge(p, comp<double>{ 1. }, 25, 1e-9);
+	EXPECT_EQ(res.iters, 0);
+}
+
+TEST(Newton, converge_stalled) {
+	static constexpr Polynome<double, 3> p{ { -1., 0., 1. } }; // x2 - 1
+	static constexpr auto res = newtonConverge(p, comp<double>{ 0. }, 25, 1e-9);
+	EXPECT_EQ(res.iters, 25);
+}
+
+TEST(Newton, cubic_methods_converge_faster) {
+	static constexpr Polynome<double, 4> p{ { -1., 0., 0., 1. } }; // x3 - 1
+	static constexpr comp<double> z{ 2., 0.5 };
+	static constexpr auto newton = newtonConverge(p, z, 100, 1e-12);
+	static constexpr auto halley = methodConverge<Method::Halley>(p, z, 100, 1e-12);
+	static constexpr auto householder = methodConverge<Method::Householder>(p, z, 100, 1e-12);
+	for (auto const& res : { halley, householder }) {
+		EXPECT_NEAR(res.z.re, 1., 1e-9);
+		EXPECT_NEAR(res.z.im, 0., 1e-9);
+		EXPECT_LT(res.iters, newton.iters);
+	}
+}
+
+TEST(Newton, relaxed_by_one_is_newton) {
+	static constexpr Polynome<double, 4> p{ { -1., 0., 0., 1. } }; // x3 - 1
+	static constexpr auto newton = newtonConverge(p, comp<double>{ -0.3, 1.2 }, 50, 1e-9);
+	static constexpr auto relaxed =
+		methodConverge<Method::Relaxed>(p, comp<double>{ -0.3, 1.2 }, 50, 1e-9, comp<double>{ 1. });
+	EXPECT_EQ(relaxed.z, newton.z);
+	EXPECT_EQ(relaxed.iters, newton.iters);
+	// a factor below one shortens every step, more of them are needed
+	auto damped = methodConverge<Method::Relaxed>(p, comp<double>{ -0.3, 1.2 }, 200, 1e-9, comp<double>{ 0.5 });
+	EXPECT_GT(damped.iters, newton.iters);
+	EXPECT_LT(damped.iters, 200);
+}
+
+TEST(Newton, halley_stalled) {
+	static constexpr Polynome<double, 3> p{ { -1., 0., 1. } }; // x2 - 1, p' vanishes at 0
+	static constexpr auto res = methodConverge<Method::Halley>(p, comp<double>{ 0. }, 25, 1e-9);
+	EXPECT_EQ(res.iters, 25);
+}
+
+TEST(Newton, closest_root) {
+	static constexpr std::array<comp<double>, 3> roots{ comp<double>{ 1. }, comp<double>{ -1. },
+							    comp<double>{ 0., 1. } };
+	EXPECT_EQ(closestRootIndex(roots, comp<double>{ 0.9, 0.1 }), 0);
+	EXPECT_EQ(closestRootIndex(roots, comp<double>{ -2., 0. }), 1);
+	EXPECT_EQ(closestRootIndex(roots, comp<double>{ 0.1, 3. }), 2);
+}
+
+TEST(Newton, runtime_sampler_same_as_unrolled) {
+	static constexpr std::array<comp<double>, 3> roots{ comp<double>{ 1. },
+							    comp<double>{ -0.5, -0.866025403784439 },
+							    comp<double>(-0.500000000000000, 0.866025403784439) };
+	auto p = polynomFromRoots(roots);
+	PixelSampler<double, 4> unrolled{ p, roots, comp<double>{ -1., -1. }, 0.05, 25, 1e-6 };
+	RuntimePixelSampler<double> runtime{ PolyView<double>{ p.coeffs().data(), 3 }, roots.data(),
+					     comp<double>{ -1., -1. }, 0.05, 25, 1e-6 };
+	for (std::size_t y = 0; y < 40; ++y) {
+		for (std::size_t x = 0; x < 40; ++x) {
+			EXPECT_EQ(unrolled(x, y).root, runtime(x, y).root);
+			EXPECT_EQ(unrolled(x, y).iters, runtime(x, y).iters);
+			EXPECT_EQ(unrolled(x, y).shade, runtime(x, y).shade);
+		}
+	}
+}
+
+TEST(Newton, approx_log2) {
+	static_assert(approxLog2(1.f) == 0.f);
+	static_assert(approxLog2(0.25f) == -2.f);
+	EXPECT_EQ(approxLog2(1024.f), 10.f);
+	for (float x : { 0.3f, 3.f, 1e-20f, 7e30f })
+		EXPECT_NEAR(approxLog2(x), std::log2(x), 0.09);
+}
+
+TEST(Newton, shade_level) {
+	// no fraction when the final iterate is just at the tolerance, up to a whole step when far below it
+	EXPECT_EQ(shadeLevel(5, 25, 1e-12, 1e-6), 5 * SHADE_STEPS);
+	EXPECT_EQ(shadeLevel(5, 25, 1e-24, 1e-6), 4 * SHADE_STEPS);
+	EXPECT_LT(shadeLevel(5, 25, 1e-18, 1e-6), 5 * SHADE_STEPS);
+	EXPECT_GT(shadeLevel(5, 25, 1e-18, 1e-6), 4 * SHADE_STEPS);
+	EXPECT_EQ(shadeLevel(5, 25, 0., 1e-6), 4 * SHADE_STEPS);
+	EXPECT_EQ(shadeLevel(0, 25, 0., 1e-6), 0);
+	// not converged
+	EXPECT_EQ(shadeLevel(25, 25, 1e-12, 1e-6), SHADE_LEVELS - 1);
+	// many cycles get fewer levels per step, so the slowest converged pixels still differ
+	EXPECT_EQ(shadeLevel(100, 254, 1e-12, 1e-6), 100);
+	EXPECT_LT(shadeLevel(198, 200, 1e-12, 1e-6), shadeLevel(199, 200, 1e-12, 1e-6));
+	EXPECT_EQ(shadeLevel(199, 200, 1e-12, 1e-6), 252);
+	EXPECT_LT(shadeLevel(990, 1000, 1e-12, 1e-6), shadeLevel(999, 1000, 1e-12, 1e-6));
+	EXPECT_EQ(shadeLevel(5, 25, ddouble{ 1e-12 }, ddouble{ 1e-6 }), 5 * SHADE_STEPS);
+	// cubic methods triple the digits at each step
+	EXPECT_EQ(shadeLevel(5, 25, 1e-36, 1e-6, 3), 4 * SHADE_STEPS);
+	EXPECT_GT(shadeLevel(5, 25, 1e-24, 1e-6, 3), 4 * SHADE_STEPS);
+}
@@ -105,6 +105,17 @@ TEST(Polynome, binary_div) {
 	}
 }
 
+TEST(Polynome, constexpr_binary_div_quotient) {
+	static constexpr Polynome<float, 4> p{ { -1., 0., 0., 1. } }; // x3 - 1
+	static constexpr Polynome<float, 2> p2{ { -1., 1. } }; // x - 1
+	static constexpr auto r = p / p2; // x2 + x + 1
+	static constexpr std::array<comp_t<float>, 4> expected{ { 1., 1., 1., 0. } };
+	for (std::size_t i = 0; i < r.coeffs().size(); ++i) {
+		EXPECT_FLOAT_EQ(r.coeffs()[i].re, expected[i].re);
+		EXPECT_FLOAT_EQ(r.coeffs()[i].im, expected[i].im);
+	}
+}
+
 static constexpr auto epsilon = 1e-12;
 
 TEST(Polynome, root_x) {
@@ -237,3 +248,152 @@ TEST(Polynome, constexpr_polyfromroot_array) {
 		EXPECT_LT(dist_squared(pz, comp<float>{ 0. }), epsilon);
 	}
 }
+
+TEST(Polynome, constexpr_apply) {
+	static constexpr Polynome<float, 4> p{ { 3., 7., 4., 2. } }; // 2x3 4x2 7x 3
+	static constexpr auto pz = p.apply(comp<float>{ 2. });
+	EXPECT_FLOAT_EQ(pz.re, 49.f);
+	EXPECT_FLOAT_EQ(pz.im, 0.f);
+}
+
+TEST(Polynome, constexpr_derivative) {
+	static constexpr Polynome<float, 4> p{ { 3., 7., 4., 2. } }; // 2x3 4x2 7x 3
+	static constexpr auto d = p.derivative(); // 6x2 8x 7
+	static constexpr std::array<comp_t<float>, 3> expected{ { 7., 8., 6. } };
+	for (std::size_t i = 0; i < d.coeffs().size(); ++i) {
+		EXPECT_FLOAT_EQ(d.coeffs()[i].re, expected[i].re);
+		EXPECT_FLOAT_EQ(d.coeffs()[i].im, expected[i].im);
+	}
+}
+
+TEST(Polynome, constexpr_apply_with_derivative) {
+	static constexpr Polynome<float, 4> p{ { 3., 7., 4., 2. } }; // 2x3 4x2 7x 3
+	static constexpr comp<float> z{ 0.5, -1. };
+	static constexpr auto e = p.apply_with_derivative(z);
+	static constexpr auto pz = p.apply(z);
+	static constexpr auto dpz = p.derivative().apply(z);
+	EXPECT_FLOAT_EQ(e.p.re, pz.re);
+	EXPECT_FLOAT_EQ(e.p.im, pz.im);
+	EXPECT_FLOAT_EQ(e.dp.re, dpz.re);
+	EXPECT_FLOAT_EQ(e.dp.im, dpz.im);
+}
+
+TEST(Polynome, constexpr_apply_with_derivatives) {
+	static constexpr Polynome<float, 4> p{ { 3., 7., 4., 2. } }; // 2x3 4x2 7x 3
+	static constexpr comp<float> z{ 0.5, -1. };
+	static constexpr auto e = p.apply_with_derivatives(z);
+	static constexpr auto pe = p.apply_with_derivative(z);
+	static constexpr auto d2pz = p.derivative().derivative().apply(z);
+	EXPECT_EQ(e.p, pe.p);
+	EXPECT_EQ(e.dp, pe.dp);
+	EXPECT_FLOAT_EQ(2.f * e.half_d2p.re, d2pz.re);
+	EXPECT_FLOAT_EQ(2.f * e.half_d2p.im, d2pz.im);
+	static constexpr PolyView<float> v{ p.coeffs().data(), 3 };
+	static constexpr auto ve = v.apply_with_derivatives(z);
+	EXPECT_EQ(ve.p, e.p);
+	EXPECT_EQ(ve.dp, e.dp);
+	EXPECT_EQ(ve.half_d2p, e.half_d2p);
+}
+
+TEST(Polynome, constexpr_apply_with_derivative_constant) {
+	static constexpr Polynome<float, 1> p{ { 3. } };
+	static constexpr auto e = p.apply_with_derivative(comp<float>{ 2. });
+	EXPECT_FLOAT_EQ(e.p.re, 3.f);
+	EXPECT_FLOAT_EQ(e.dp.re, 0.f);
+}
+
+TEST(PolyView, same_as_polynome) {
+	static constexpr Polynome<double, 4> p{ { 3., 7., 4., 2. } }; // 2x3 4x2 7x 3
+	static constexpr PolyView<double> v{ p.coeffs().data(), 3 };
+	static constexpr comp<double> z{ 0.5, -1. };
+	static constexpr auto e = v.apply_with_derivative(z);
+	static constexpr auto pe = p.apply_with_derivative(z);
+	EXPECT_EQ(e.p, pe.p);
+	EXPECT_EQ(e.dp, pe.dp);
+	EXPECT_EQ(v.apply(z), p.apply(z));
+}
+
+TEST(PolyView, coeffs_from_roots) {
+	std::vector<comp<double>> roots{ comp<double>{ 1. }, comp<double>{ -1. }, comp<double>{ 0., 2. } };
+	auto c = coeffsFromRoots(roots); // (x2 - 1)(x - 2i) = x3 - 2i x2 - x + 2i
+	auto expected = polynomFromRoots(roots[0], roots[1], roots[2]).coeffs();
+	ASSERT_EQ(c.size(), expected.size());
+	for (std::size_t i = 0; i < c.size(); ++i)
+		EXPECT_EQ(c[i], expected[i]);
+}
+
+TEST(PolyView, runtime_roots) {
+	for (int d : { 1, 2, 5, 12, 20 }) {
+		std::vector<comp<double>> c(d + 1);
+		c[0] = comp<double>{ -2. };
+		c[d] = comp<double>{ 2. }; // 2x^d - 2
+		c.push_back(comp<double>{}); // ignored
+		auto r = polyRoots(c);
+		ASSERT_EQ(r.size(), static_cast<std::size_t>(d));
+		PolyView<double> v{ c.data(), d };
+		for (auto const& z : r) {
+			EXPECT_NEAR(v.apply(z).re, 0., 1e-12);
+			EXPECT_NEAR(v.apply(z).im, 0., 1e-12);
+		}
+		for (std::size_t i = 0; i < r.size(); ++i) {
+			for (std::size_t j = i + 1; j < r.size(); ++j)
+				EXPECT_GT(dist_squared(r[i], r[j]), 1e-6);
+		}
+	}
+}
+
+TEST(PolyView, runtime_roots_constant) {
+	EXPECT_THROW(polyRoots(std::vector<comp<double>>{ comp<double>{ 1. }, comp<double>{} }), std::invalid_argument);
+}
+
+TEST(Polynome, constexpr_roots_high_degree) {
+	static constexpr std::array<comp<double>, 8> expected{
+		comp<double>{ 1. }, comp<double>{ -2., 0.5 }, comp<double>{ 0.3, -1.2 }, comp<double>{ 3., 3. },
+		comp<double>{ -0.7, -0.1 }, comp<double>{ 0., 2. }, comp<double>{ 0.5, 0.5 }, comp<double>{ -4. }
+	};
+	static constexpr auto p = polynomFromRoots(expected);
+	static constexpr auto roots = p.roots();
+	// every expected root is found once
+	for (auto const& e : expected) {
+		auto closest = *std::min_element(roots.begin(), roots.end(), [&](auto const& l, auto const& r) {
+			return dist_squared(l, e) < dist_squared(r, e);
+		});
+		EXPECT_NEAR(closest.re, e.re, 1e-12);
+		EXPECT_NEAR(closest.im, e.im, 1e-12);
+	}
+	for (std::size_t i = 0; i < roots.size(); ++i) {
+		for (std::size_t j = i + 1; j < roots.size(); ++j)
+			EXPECT_GT(dist_squared(roots[i], roots[j]), 1e-6);
+	}
+}
+
+TEST(PolyView, runtime_roots_zero) {
+	// x^2 (x - 2i), the double root 0 is exact
+	auto r = polyRoots(std::vector<comp<double>>{ comp<double>{}, comp<double>{}, comp<double>{ 0., -2. },
+						      comp<double>{ 1. } });
+	ASSERT_EQ(r.size(), 3u);
+	EXPECT_EQ(r[0], comp<double>{});
+	EXPECT_EQ(r[1], comp<double>{});
+	EXPECT_NEAR(r[2].im, 2., 1e-14);
+}
+
+TEST(PolyView, runtime_roots_batch) {
+	// z^3 - t for a sweep of t, every root has t as its cube
+	std::vector<std::vector<comp<double>>> family;
+	for (int i = 1; i <= 50; ++i)
+		family.push_back(
+			{ comp<double>{ -0.1 * i, 0.02 * i }, comp<double>{}, comp<double>{}, comp<double>{ 1. } });
+	auto roots = polyRootsBatch(family);
+	ASSERT_EQ(roots.size(), family.size());
+	for (std::size_t i = 0; i < family.size(); ++i) {
+		ASSERT_EQ(roots[i].size(), 3u);
+		EXPECT_EQ(roots[i], polyRoots(family[i]));
+		for (auto const& z : roots[i]) {
+			auto cube = z * z * z;
+			EXPECT_NEAR(cube.re, -family[i][0].re, 1e-12);
+			EXPECT_NEAR(cube.im, -family[i][0].im, 1e-12);
+		}
+	}
+	family.push_back({ comp<double>{ 1. } });
+	EXPECT_THROW(polyRootsBatch(family), std::invalid_argument);
+}
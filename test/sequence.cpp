@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "sequence.hpp"
+
+TEST(Sequence, parse_keyframes) {
+	std::istringstream is{ "# zoom on the origin\n"
+			       "0 -0.4,0 0.01 20 1 -0.5,-0.8 -0.5,0.8\n"
+			       "\n"
+			       "2.5 0,0.1 0.0001 40\n" };
+	auto keys = parseKeyframes(is);
+	ASSERT_EQ(keys.size(), 2u);
+	EXPECT_EQ(keys[0].center, comp<double>(-0.4, 0.));
+	EXPECT_EQ(keys[0].cycles, 20u);
+	ASSERT_EQ(keys[0].roots.size(), 3u);
+	EXPECT_EQ(keys[0].roots[1], comp<double>(-0.5, -0.8));
+	EXPECT_DOUBLE_EQ(keys[1].time, 2.5);
+	EXPECT_DOUBLE_EQ(keys[1].inc, 0.0001);
+	// roots are kept from the previous keyframe
+	EXPECT_EQ(keys[1].roots, keys[0].roots);
+
+	std::istringstream backwards{ "1 0,0 0.1 10\n0 0,0 0.1 10\n" };
+	EXPECT_THROW(parseKeyframes(backwards), std::invalid_argument);
+	std::istringstream missing{ "0 0,0 0.1\n" };
+	EXPECT_THROW(parseKeyframes(missing), std::invalid_argument);
+	std::istringstream empty{ "# nothing\n" };
+	EXPECT_THROW(parseKeyframes(empty), std::invalid_argument);
+}
+
+TEST(Sequence, interpolate) {
+	std::vector<Keyframe> keys{ { 0., comp<double>(0., 0.), 0.01, 10, { comp<double>(1.), comp<double>(-1.) } },
+				    { 2., comp<double>(2., -2.), 0.0001, 30, { comp<double>(3.), comp<double>(1.) } } };
+	auto mid = interpolate(keys, 1.);
+	EXPECT_EQ(mid.center, comp<double>(1., -1.));
+	// geometric mean, so every frame zooms by the same factor
+	EXPECT_NEAR(mid.inc, 0.001, 1e-15);
+	EXPECT_EQ(mid.cycles, 20u);
+	ASSERT_EQ(mid.roots.size(), 2u);
+	EXPECT_EQ(mid.roots[0], comp<double>(2.));
+	EXPECT_EQ(interpolate(keys, -1.).center, keys.front().center);
+	EXPECT_EQ(interpolate(keys, 5.).cycles, 30u);
+
+	EXPECT_EQ(frameCount(keys, 30), 61u);
+	EXPECT_EQ(frameCount({ keys.front() }, 30), 1u);
+}
+
+TEST(Sequence, frame_name) {
+	EXPECT_EQ(frameName("zoom####.png", 42), "zoom0042.png");
+	EXPECT_EQ(frameName("a#/f##.ppm", 123), "a#/f123.ppm");
+	EXPECT_THROW(frameName("zoom.png", 0), std::invalid_argument);
+}
+
+TEST(Sequence, resample) {
+	// reference twice as fine as the frames, each pixel holds its coordinates
+	FrameView ref{ comp<double>(0., 0.), 0.5, 8, 6 };
+	std::vector<Rgba> refPixels(ref.width * ref.height);
+	for (std::size_t y = 0; y < ref.height; ++y)
+		for (std::size_t x = 0; x < ref.width; ++x)
+			refPixels[y * ref.width + x] =
+				Rgba{ static_cast<std::uint8_t>(x), static_cast<std::uint8_t>(y), 0, 255 };
+
+	FrameView same{ comp<double>(0., 0.), 0.5, 8, 6 };
+	std::vector<Rgba> out(same.width * same.height);
+	ASSERT_TRUE(canResample(ref, same));
+	resample(ref, refPixels.data(), same, out.data());
+	for (std::size_t i = 0; i < out.size(); ++i)
+		EXPECT_EQ(out[i].r + 256 * out[i].g, refPixels[i].r + 256 * refPixels[i].g);
+
+	FrameView coarse{ comp<double>(1., 0.5), 1., 3, 2 };
+	ASSERT_TRUE(canResample(ref, coarse));
+	out.resize(coarse.width * coarse.height);
+	resample(ref, refPixels.data(), coarse, out.data());
+	EXPECT_EQ(out[0].r, 2);
+	EXPECT_EQ(out[0].g, 1);
+	EXPECT_EQ(out[5].r, 6);
+	EXPECT_EQ(out[5].g, 3);
+
+	// finer than the reference, or outside of it
+	EXPECT_FALSE(canResample(ref, FrameView{ comp<double>(0., 0.), 0.25, 4, 4 }));
+	EXPECT_FALSE(canResample(ref, FrameView{ comp<double>(2., 0.), 1., 3, 2 }));
+	EXPECT_THROW(resample(ref, refPixels.data(), FrameView{ comp<double>(-1., 0.), 1., 2, 2 }, out.data()),
+		     std::invalid_argument);
+}
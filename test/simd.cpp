@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "newton.hpp"
+#include "poly.hpp"
+#include "simd.hpp"
+
+namespace
+{
+// Degree 5 with complex coefficients, sampled on a grid whose size is not a multiple of any vector width
+template <typename T, Method M>
+void expectSameAsRuntimeSampler(SimdIsa isa) {
+	std::vector<comp<T>> roots{ comp<T>{ 1. }, comp<T>{ -0.7, 0.4 }, comp<T>{ 0.2, -0.9 }, comp<T>{ -0.3, -0.5 },
+				    comp<T>{ 0.5, 0.8 } };
+	auto coeffs = coeffsFromRoots(roots);
+	comp<T> top_left{ -1.5, -1. };
+	T inc = 0.045;
+	comp<T> relaxation{ 0.8, 0.3 };
+	RuntimePixelSampler<T, M> sampler{ PolyView<T>{ coeffs.data(), 5 }, roots.data(),
+					   comp_cast<SampleCoord<T>>(top_left), inc, 40, 1e-4, relaxation };
+
+	SimdView<T> view{ {}, {}, {}, {}, top_left.re, top_left.im, inc, 40, 1e-4, M, relaxation.re, relaxation.im };
+	for (auto const& c : coeffs) {
+		view.coeffsRe.push_back(c.re);
+		view.coeffsIm.push_back(c.im);
+	}
+	for (auto const& r : roots) {
+		view.rootsRe.push_back(r.re);
+		view.rootsIm.push_back(r.im);
+	}
+	std::vector<Pixel> pixels;
+	for (std::uint32_t y = 0; y < 37; ++y)
+		for (std::uint32_t x = 0; x < 67; ++x)
+			pixels.push_back({ x, y });
+	std::vector<std::uint8_t> res(pixels.size());
+	std::vector<int> iters(pixels.size());
+	std::vector<std::uint8_t> shades(pixels.size());
+	simdSample(view, pixels.data(), pixels.size(), res.data(), iters.data(), shades.data(), isa);
+
+	for (std::size_t i = 0; i < pixels.size(); ++i) {
+		auto expected = sampler(pixels[i].x, pixels[i].y);
+		EXPECT_EQ(res[i], expected.root) << simdIsaName(isa) << " " << methodName(M) << " pixel " << i;
+		EXPECT_EQ(iters[i], expected.iters) << simdIsaName(isa) << " " << methodName(M) << " pixel " << i;
+		EXPECT_EQ(shades[i], expected.shade) << simdIsaName(isa) << " " << methodName(M) << " pixel " << i;
+	}
+}
+} // namespace
+
+TEST(Simd, same_as_runtime_sampler) {
+	for (auto isa : { SimdIsa::Generic, SimdIsa::Avx2, SimdIsa::Avx512 }) {
+		if (!simdIsaAvailable(isa))
+			continue;
+		expectSameAsRuntimeSampler<float, Method::Newton>(isa);
+		expectSameAsRuntimeSampler<double, Method::Newton>(isa);
+	}
+}
+
+TEST(Simd, same_as_runtime_sampler_every_method) {
+	for (auto isa : { SimdIsa::Generic, SimdIsa::Avx2, SimdIsa::Avx512 }) {
+		if (!simdIsaAvailable(isa))
+			continue;
+		expectSameAsRuntimeSampler<double, Method::Halley>(isa);
+		expectSameAsRuntimeSampler<double, Method::Householder>(isa);
+		expectSameAsRuntimeSampler<double, Method::Relaxed>(isa);
+		expectSameAsRuntimeSampler<float, Method::Halley>(isa);
+	}
+}
+
+TEST(Simd, generic_always_available) {
+	EXPECT_TRUE(simdIsaAvailable(SimdIsa::Generic));
+	EXPECT_TRUE(simdIsaAvailable(bestSimdIsa()));
+}
+
+TEST(Simd, rejects_missing_roots) {
+	SimdView<double> view{ { 1., 0., 1. }, { 0., 0., 0. }, { 0. }, { 1. }, 0., 0., 1., 10, 1e-6 };
+	Pixel p{ 0, 0 };
+	std::uint8_t root, shade;
+	int iters;
+	EXPECT_THROW(simdSample(view, &p, 1, &root, &iters, &shade), std::invalid_argument);
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "stats.hpp"
+
+namespace
+{
+std::string readFile(std::filesystem::path const& p) {
+	std::ifstream ifs{ p };
+	std::stringstream ss;
+	ss << ifs.rdbuf();
+	return ss.str();
+}
+} // namespace
+
+TEST(Stats, csv_header_once) {
+	auto path = std::filesystem::temp_directory_path() / "newton_stats_test.csv";
+	{
+		FrameStatsLog log{ path.string() };
+		log.write(FrameStats{ .frame = 1, .kernels = 2, .pixels = 3 });
+		log.write(FrameStats{ .frame = 2 });
+	}
+	auto s = readFile(path);
+	std::filesystem::remove(path);
+	EXPECT_EQ(s.find("frame,wall"), 0u);
+	EXPECT_EQ(s.find("frame,wall", 1), std::string::npos);
+	EXPECT_NE(s.find("\n1,0,0,0,0,0,0,0,2,3,0,0\n"), std::string::npos);
+	EXPECT_NE(s.find("\n2,"), std::string::npos);
+}
+
+TEST(Stats, json_lines) {
+	auto path = std::filesystem::temp_directory_path() / "newton_stats_test.jsonl";
+	{
+		FrameStatsLog log{ path.string() };
+		log.write(FrameStats{ .frame = 4, .wall = 0.5 });
+	}
+	auto s = readFile(path);
+	std::filesystem::remove(path);
+	EXPECT_EQ(s.find("{\"frame\":4,\"wall\":0.5,"), 0u);
+	EXPECT_EQ(s.back(), '\n');
+}
+
+TEST(Stats, unwritable_path) { EXPECT_THROW(FrameStatsLog{ "/nonexistent/dir/stats.csv" }, std::runtime_error); }
@@ -0,0 +1,253 @@
+#pragma once
+
+// Host implementation of the part of SYCL used by FractalComputer, so its scheduler can be tested without a SYCL
+// compiler nor a device. Kernels are only queued when submitted, like on a busy device, and run in submission order
+// once a queue is waited for or stub::runKernels is called.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cl::sycl
+{
+template <int D>
+struct range {
+	std::size_t v[D];
+
+	template <typename... S>
+	range(S... s) : v{ static_cast<std::size_t>(s)... } {}
+
+	std::size_t operator[](int i) const { return v[i]; }
+	std::size_t size() const {
+		std::size_t ret = 1;
+		for (int i = 0; i < D; ++i)
+			ret *= v[i];
+		return ret;
+	}
+};
+
+template <int D>
+struct id {
+	std::size_t v[D];
+
+	std::size_t operator[](int i) const { return v[i]; }
+};
+
+struct exception : std::runtime_error {
+	using std::runtime_error::runtime_error;
+};
+using exception_list = std::vector<std::exception_ptr>;
+
+namespace info
+{
+namespace device
+{
+struct name {};
+struct vendor {};
+} // namespace device
+namespace platform
+{
+struct name {};
+} // namespace platform
+namespace event
+{
+struct command_execution_status {};
+} // namespace event
+enum class event_command_status { submitted, running, complete };
+namespace event_profiling
+{
+struct command_start {};
+struct command_end {};
+} // namespace event_profiling
+} // namespace info
+
+namespace stub
+{
+// Devices listed by device::get_devices, set it before constructing a FractalComputer to split its frames
+inline std::size_t deviceCount = 1;
+
+struct Command {
+	std::function<void()> kernel;
+	bool done = false;
+	std::uint64_t start = 0, end = 0;
+};
+
+// Kernels submitted to every queue and not run yet, the stub is a single in-order device
+inline std::deque<std::shared_ptr<Command>> commands;
+
+inline std::uint64_t nowNs() {
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+						  std::chrono::steady_clock::now().time_since_epoch())
+						  .count());
+}
+
+inline void runKernels() {
+	while (!commands.empty()) {
+		auto c = std::move(commands.front());
+		commands.pop_front();
+		c->start = nowNs();
+		c->kernel();
+		c->end = nowNs();
+		c->done = true;
+	}
+}
+} // namespace stub
+
+struct platform {
+	template <typename Param>
+	std::string get_info() const {
+		return "stub platform";
+	}
+};
+
+struct default_selector {};
+inline constexpr default_selector default_selector_v{};
+
+struct device {
+	std::size_t index = 0;
+
+	device() = default;
+	explicit device(default_selector) {}
+
+	static std::vector<device> get_devices() {
+		std::vector<device> ret(stub::deviceCount);
+		for (std::size_t i = 0; i < ret.size(); ++i)
+			ret[i].index = i;
+		return ret;
+	}
+
+	template <typename Param>
+	std::string get_info() const {
+		return "stub device " + std::to_string(index);
+	}
+	platform get_platform() const { return {}; }
+};
+
+namespace property::queue
+{
+struct enable_profiling {};
+} // namespace property::queue
+
+struct property_list {
+	template <typename... P>
+	property_list(P...) {}
+};
+
+struct read_only_t {};
+struct write_only_t {};
+inline constexpr read_only_t read_only{};
+inline constexpr write_only_t write_only{};
+
+// Default constructed events are complete, like the ones of the SIMD engine's tiles which never run a kernel
+class event {
+	std::shared_ptr<stub::Command> command;
+
+    public:
+	event() : command{ std::make_shared<stub::Command>(stub::Command{ {}, true }) } {}
+	explicit event(std::shared_ptr<stub::Command> c) : command{ std::move(c) } {}
+
+	template <typename Param>
+	std::uint64_t get_profiling_info() const {
+		if constexpr (std::is_same_v<Param, info::event_profiling::command_start>)
+			return command->start;
+		else
+			return command->end;
+	}
+
+	template <typename Param>
+	info::event_command_status get_info() const {
+		return command->done ? info::event_command_status::complete : info::event_command_status::submitted;
+	}
+};
+
+template <typename V, int D>
+class buffer {
+	std::shared_ptr<std::vector<V>> values;
+
+    public:
+	buffer(range<D> r) : values{ std::make_shared<std::vector<V>>(r.size()) } {}
+
+	std::size_t size() const { return values->size(); }
+	V* data() const { return values->data(); }
+
+	struct host_accessor {
+		std::vector<V>* v;
+
+		V* begin() { return v->data(); }
+		V* end() { return v->data() + v->size(); }
+	};
+
+	template <typename Mode>
+	host_accessor get_host_access(Mode) {
+		return { values.get() };
+	}
+};
+
+class handler {
+	friend class queue;
+	std::function<void()> kernel;
+
+    public:
+	template <int D, typename F>
+	void parallel_for(range<D> r, F f) {
+		kernel = [r, f] {
+			if constexpr (D == 1) {
+				for (std::size_t i = 0; i < r[0]; ++i)
+					f(id<1>{ { i } });
+			} else {
+				for (std::size_t i = 0; i < r[0]; ++i) {
+					for (std::size_t j = 0; j < r[1]; ++j)
+						f(id<2>{ { i, j } });
+				}
+			}
+		};
+	}
+};
+
+template <typename V, int D = 1>
+struct accessor {
+	V* ptr;
+
+	template <typename Mode>
+	accessor(buffer<V, D>& b, handler&, Mode) : ptr{ b.data() } {}
+
+	V& operator[](id<D> i) const { return ptr[i[0]]; }
+};
+
+template <typename V, int D, typename Mode>
+accessor(buffer<V, D>&, handler&, Mode) -> accessor<V, D>;
+
+class queue {
+    public:
+	queue() = default;
+	template <typename Handler>
+	queue(device const&, Handler const&, property_list const& = {}) {}
+
+	template <typename F>
+	event submit(F f) {
+		handler cgh;
+		f(cgh);
+		auto c = std::make_shared<stub::Command>(stub::Command{ std::move(cgh.kernel) });
+		stub::commands.push_back(c);
+		return event{ std::move(c) };
+	}
+
+	void wait() { stub::runKernels(); }
+	void wait_and_throw() { stub::runKernels(); }
+};
+
+template <typename V>
+V* malloc_host(std::size_t n, queue const&) {
+	return static_cast<V*>(std::malloc(n * sizeof(V)));
+}
+
+inline void free(void* ptr, queue const&) { std::free(ptr); }
+} // namespace cl::sycl
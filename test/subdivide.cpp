@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "newton.hpp"
+#include "subdivide.hpp"
+
+namespace
+{
+struct View {
+	comp<double> top_left;
+	double inc;
+};
+
+static constexpr std::array<comp<double>, 3> roots{ comp<double>{ 1. }, comp<double>{ -0.5, -0.866025403784439 },
+						    comp<double>(-0.500000000000000, 0.866025403784439) };
+
+// Number of pixels which differ from the brute force frame, and number of pixels actually computed
+std::pair<std::size_t, std::size_t> compareWithBruteForce(View const& v, std::size_t w, std::size_t h) {
+	PixelSampler<double, 4> sample{ polynomFromRoots(roots), roots, v.top_left, v.inc, 25, 1e-6 };
+
+	std::vector<int> fr(w * h, -1), fi(w * h, -1);
+	auto computed = subdivideFill(w, h, fr, fi, sample);
+
+	std::size_t diff = 0;
+	for (std::size_t y = 0; y < h; ++y) {
+		for (std::size_t x = 0; x < w; ++x) {
+			if (fr[y * w + x] != sample(x, y).root)
+				++diff;
+		}
+	}
+	return { diff, computed };
+}
+} // namespace
+
+TEST(Subdivide, full_view) {
+	auto [diff, computed] = compareWithBruteForce({ { -2., -1.2 }, 0.01 }, 400, 240);
+	EXPECT_EQ(diff, 0u);
+	EXPECT_LT(computed, 400u * 240u);
+}
+
+TEST(Subdivide, zoomed_view) {
+	auto [diff, computed] = compareWithBruteForce({ { -0.6, -0.1 }, 0.001 }, 320, 200);
+	EXPECT_EQ(diff, 0u);
+	EXPECT_LT(computed, 320u * 200u);
+}
+
+TEST(Subdivide, smooth_view_skips_most_pixels) {
+	auto [diff, computed] = compareWithBruteForce({ { 1.5, -0.5 }, 0.005 }, 256, 256);
+	EXPECT_EQ(diff, 0u);
+	EXPECT_LT(computed, 256u * 256u / 4);
+}
+
+TEST(Subdivide, tiny_frames) {
+	for (std::size_t w = 1; w < 5; ++w) {
+		for (std::size_t h = 1; h < 5; ++h) {
+			EXPECT_EQ(compareWithBruteForce({ { -2., -1.2 }, 0.3 }, w, h).first, 0u);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+// SYCL is the host stub of test/stub, RootDrag is tested against a FractalComputer
+#include "compute.hpp"
+#include "view.hpp"
+
+namespace
+{
+std::vector<comp<double>> const roots{ comp<double>{ 1. }, comp<double>{ -0.5, -0.866025403784439 },
+				       comp<double>{ -0.5, 0.866025403784439 } };
+} // namespace
+
+TEST(View, pixels_to_complex_and_back) {
+	ViewMapping<double> view{ { -0.2, 0.1 }, 0.02, 160, 120 };
+	EXPECT_NEAR(view.toComplex(80, 60).re, -0.2, 1e-12);
+	EXPECT_NEAR(view.toComplex(80, 60).im, 0.1, 1e-12);
+	EXPECT_EQ(view.toComplex(0, 0), view.top_left);
+	EXPECT_NEAR(view.toComplex(10, 0).re - view.top_left.re, 0.2, 1e-12);
+	EXPECT_NEAR(view.toComplex(0, 10).im - view.top_left.im, 0.2, 1e-12);
+	for (auto [x, y] : { std::pair{ 0, 0 }, std::pair{ 159, 0 }, std::pair{ 13, 97 }, std::pair{ -20, 140 } }) {
+		auto p = view.toPixel(view.toComplex(x, y));
+		EXPECT_NEAR(p.x, x, 1e-3);
+		EXPECT_NEAR(p.y, y, 1e-3);
+	}
+}
+
+TEST(View, root_at_grab_radius) {
+	ViewMapping<double> view{ { 0., 0. }, 0.02, 160, 120 };
+	auto p = view.toPixel(roots[0]); // (130, 60)
+	auto x = static_cast<int>(p.x), y = static_cast<int>(p.y);
+	EXPECT_EQ(rootAt(view, roots, x, y, 16.f), 0u);
+	EXPECT_EQ(rootAt(view, roots, x - 10, y + 10, 16.f), 0u);
+	EXPECT_EQ(rootAt(view, roots, x - 12, y + 12, 16.f), std::nullopt);
+	EXPECT_EQ(rootAt(view, roots, 80, 60, 16.f), std::nullopt);
+	// the closest of two roots within the radius
+	std::vector<comp<double>> close{ roots[0], roots[0] + comp<double>{ 0.2, 0. } };
+	EXPECT_EQ(rootAt(view, close, x + 4, y, 16.f), 0u);
+	EXPECT_EQ(rootAt(view, close, x + 6, y, 16.f), 1u);
+}
+
+TEST(View, drag_previews_until_release) {
+	FractalComputer<double> c{ roots, { 0., 0. }, 0.02, 160, 120, 25 };
+	auto view = viewMapping(c);
+	RootDrag<double> drag;
+	// nothing to grab in the middle of the view
+	drag.press(c, 80, 60);
+	EXPECT_FALSE(drag.dragging());
+	EXPECT_FALSE(c.getPreview());
+
+	auto p = view.toPixel(roots[0]);
+	drag.press(c, static_cast<int>(p.x), static_cast<int>(p.y));
+	ASSERT_TRUE(drag.dragging());
+	EXPECT_TRUE(c.getPreview());
+	// the moves of a display frame are applied at once, markers follow the mouse meanwhile
+	drag.move(c, 120, 50);
+	drag.move(c, 110, 40);
+	EXPECT_EQ(c.getRoots()[0], roots[0]);
+	EXPECT_EQ(drag.roots(c)[0], view.toComplex(110, 40));
+	drag.apply(c);
+	EXPECT_EQ(c.getRoots()[0], view.toComplex(110, 40));
+	EXPECT_EQ(c.getRoots()[1], roots[1]);
+
+	drag.move(c, 100, 30);
+	drag.release(c);
+	EXPECT_FALSE(drag.dragging());
+	EXPECT_FALSE(c.getPreview());
+	EXPECT_EQ(c.getRoots()[0], view.toComplex(100, 30));
+	// moves are ignored once released
+	drag.move(c, 90, 20);
+	drag.apply(c);
+	EXPECT_EQ(c.getRoots()[0], view.toComplex(100, 30));
+}
@@ -0,0 +1,45 @@
+// Worker process of the farm tests, pixel (x, y) of the image holds x and y. It can misbehave on one band:
+//   farm-test-worker WIDTH                     renders every band
+//   farm-test-worker WIDTH crash BAND MARKER   exits halfway through BAND unless MARKER exists, creating it first
+//   farm-test-worker WIDTH fail BAND           always exits halfway through BAND
+//   farm-test-worker WIDTH hang BAND MARKER    stops halfway through BAND unless MARKER exists, creating it first
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "farm.hpp"
+
+int main(int argc, char* argv[]) {
+	if (argc < 2)
+		return 2;
+	auto width = std::stoul(argv[1]);
+	std::string mode = argc > 3 ? argv[2] : "";
+	auto faulty = argc > 3 ? std::stoul(argv[3]) : 0;
+	std::string marker = argc > 4 ? argv[4] : "";
+
+	Band b;
+	std::vector<Rgba> pixels;
+	while (receiveBand(0, b) && b.h > 0) {
+		pixels.resize(width * b.h);
+		for (std::size_t i = 0; i < pixels.size(); ++i) {
+			auto y = b.y + i / width;
+			pixels[i] = Rgba{ static_cast<std::uint8_t>(i % width), static_cast<std::uint8_t>(y),
+					  static_cast<std::uint8_t>(y >> 8), 255 };
+		}
+		auto once = mode == "crash" || mode == "hang";
+		auto fails = b.id == faulty && (mode == "fail" || (once && !std::ifstream{ marker }));
+		if (fails && once)
+			std::ofstream{ marker };
+		sendBand(1, b);
+		sendPixels(1, pixels.data(), fails ? pixels.size() / 2 : pixels.size());
+		// a stalled worker is killed by the coordinator
+		while (fails && mode == "hang")
+			pause();
+		if (fails)
+			_exit(3);
+	}
+	return 0;
+}